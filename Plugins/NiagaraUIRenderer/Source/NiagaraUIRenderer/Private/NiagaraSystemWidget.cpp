@@ -4,6 +4,13 @@
 #include "Materials/MaterialInterface.h"
 #include "NiagaraUIComponent.h"
 #include "NiagaraMeshRendererProperties.h"
+#include "NiagaraUIMeshDataCache.h"
+#include "NiagaraUISharedSimulations.h"
+#include "NiagaraUIPrewarmSubsystem.h"
+#include "NiagaraSystem.h"
+#include "Engine/StaticMesh.h"
+#include "StaticMeshResources.h"
+#include "Algo/Sort.h"
 
 UNiagaraSystemWidget::UNiagaraSystemWidget(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
 {
@@ -12,7 +19,7 @@ UNiagaraSystemWidget::UNiagaraSystemWidget(const FObjectInitializer& ObjectIniti
 
 TSharedRef<SWidget> UNiagaraSystemWidget::RebuildWidget()
 {
-	NiagaraSlateWidget = SNew(SNiagaraUISystemWidget);
+	NiagaraSlateWidget = SNew(SNiagaraUISystemWidget).OwnerWidget(this);
 
 	InitializeNiagaraUI();
 
@@ -33,13 +40,22 @@ void UNiagaraSystemWidget::SynchronizeProperties()
 	
 }
 
+void UNiagaraSystemWidget::PostLoad()
+{
+	Super::PostLoad();
+
+	ShareSerializedMeshData();
+}
+
 void UNiagaraSystemWidget::ReleaseSlateResources(bool bReleaseChildren)
 {
 	Super::ReleaseSlateResources(bReleaseChildren);
 	
 	NiagaraSlateWidget.Reset();
 
-	if (NiagaraComponent)
+	if (UsesSharedSimulation)
+		ReleaseSharedSimulation();
+	else if (NiagaraComponent)
 		NiagaraComponent->UnregisterComponent();
 }
 
@@ -58,150 +74,243 @@ void UNiagaraSystemWidget::PostEditChangeProperty(FPropertyChangedEvent& Propert
 		if (PropertyName == GET_MEMBER_NAME_CHECKED(UNiagaraSystemWidget, NiagaraSystemReference)
 			|| PropertyName == GET_MEMBER_NAME_CHECKED(UNiagaraSystemWidget, AutoActivate)
 			|| PropertyName == GET_MEMBER_NAME_CHECKED(UNiagaraSystemWidget, FakeDepthScale)
-			|| PropertyName == GET_MEMBER_NAME_CHECKED(UNiagaraSystemWidget, FakeDepthScaleDistance))
+			|| PropertyName == GET_MEMBER_NAME_CHECKED(UNiagaraSystemWidget, FakeDepthScaleDistance)
+			|| PropertyName == GET_MEMBER_NAME_CHECKED(UNiagaraSystemWidget, AsyncGeneration)
+			|| PropertyName == GET_MEMBER_NAME_CHECKED(UNiagaraSystemWidget, BudgetPriority))
+		{
+			InitializeNiagaraUI();
+		}
+		else if (PropertyName == GET_MEMBER_NAME_CHECKED(UNiagaraSystemWidget, SimulationRate) && NiagaraComponent)
 		{
+			// Shared simulations are keyed by their rate, the widget moves to the simulation of the new one
+			if (UsesSharedSimulation)
+			{
+				ReleaseSharedSimulation();
+				if (NiagaraSlateWidget.IsValid())
+					InitializeNiagaraUI();
+			}
+			else
+			{
+				NiagaraComponent->SetSimulationRate(SimulationRate);
+			}
+		}
+		else if (PropertyName == GET_MEMBER_NAME_CHECKED(UNiagaraSystemWidget, ShareSimulation) && NiagaraSlateWidget.IsValid())
+		{
+			if (UsesSharedSimulation)
+				ReleaseSharedSimulation();
+			else if (NiagaraComponent)
+				NiagaraComponent->UnregisterComponent();
+
+			NiagaraComponent = nullptr;
 			InitializeNiagaraUI();
 		}
 	}
 }
 
-static void StaticMeshToSlateRenderData(UStaticMesh& DataSource, TArray<FSlateMeshVertex>& OutSlateVerts, TArray<uint32>& OutIndexes, FVector2D& OutExtentMin, FVector2D& OutExtentMax)
+void UNiagaraSystemWidget::ValidateCompiledDefaults(class IWidgetCompilerLog& CompileLog) const
+{
+    Super::ValidateCompiledDefaults(CompileLog);
+
+    BakeSerializedMeshData();
+}
+
+void UNiagaraSystemWidget::PreSave(const class ITargetPlatform* TargetPlatform)
 {
-    OutExtentMin = FVector2D(FLT_MAX, FLT_MAX);
-    OutExtentMax = FVector2D(-FLT_MAX, -FLT_MAX);
+    Super::PreSave(TargetPlatform);
 
-    const FStaticMeshLODResources& LOD = DataSource.RenderData->LODResources[0];
-    const int32 NumSections = LOD.Sections.Num();
-    if (NumSections > 1)
+    // Cooked meshes usually don't keep their vertices on the CPU, so the geometry is baked into the cooked widget
+    if (TargetPlatform)
     {
-        UE_LOG(LogTemp, Warning, TEXT("StaticMesh %s has %d sections. SMeshWidget expects a static mesh with 1 section."), *DataSource.GetName(), NumSections);
+        BakeSerializedMeshData();
     }
-    else
+}
+#endif
+
+static bool BakeStaticMeshLOD(const UStaticMesh& StaticMesh, int32 LODIndex, FSlateMeshData& OutMeshData)
+{
+    const FStaticMeshLODResources& LOD = StaticMesh.RenderData->LODResources[LODIndex];
+    const FPositionVertexBuffer& PositionBuffer = LOD.VertexBuffers.PositionVertexBuffer;
+    const int32 NumVerts = PositionBuffer.GetNumVertices();
+    const bool HasColors = LOD.VertexBuffers.ColorVertexBuffer.GetNumVertices() > 0;
+    const bool HasUVs = LOD.GetNumTexCoords() > 0;
+
+    OutMeshData.LODIndex = LODIndex;
+    OutMeshData.ScreenSize = StaticMesh.RenderData->ScreenSize[LODIndex].Default;
+    OutMeshData.Vertex.SetNumUninitialized(NumVerts);
+    OutMeshData.VertexColor.SetNumUninitialized(NumVerts);
+    OutMeshData.UV.SetNumUninitialized(NumVerts);
+
+    float RadiusSquared = 0.f;
+    for (int32 i = 0; i < NumVerts; ++i)
     {
-        // Populate Vertex Data
-        {
-            const uint32 NumVerts = LOD.VertexBuffers.PositionVertexBuffer.GetNumVertices();
-            OutSlateVerts.Empty();
-            OutSlateVerts.Reserve(NumVerts);
+        const FVector& Position = PositionBuffer.VertexPosition(i);
+        OutMeshData.Vertex[i] = FVector2D(Position.X, Position.Y);
+        OutMeshData.VertexColor[i] = HasColors ? LOD.VertexBuffers.ColorVertexBuffer.VertexColor(i) : FColor::White;
+        OutMeshData.UV[i] = HasUVs ? LOD.VertexBuffers.StaticMeshVertexBuffer.GetVertexUV(i, 0) : FVector2D(1, 1);
+        RadiusSquared = FMath::Max(RadiusSquared, OutMeshData.Vertex[i].SizeSquared());
+    }
+    OutMeshData.Radius = FMath::Sqrt(RadiusSquared);
 
-            static const int32 MAX_SUPPORTED_UV_SETS = 6;
-            const int32 TexCoordsPerVertex = LOD.GetNumTexCoords();
-            if (TexCoordsPerVertex > MAX_SUPPORTED_UV_SETS)
-            {
-                UE_LOG(LogTemp, Warning, TEXT("[%s] has %d UV sets; slate vertex data supports at most %d"), *DataSource.GetName(), TexCoordsPerVertex, MAX_SUPPORTED_UV_SETS);
-            }
+    // All sections are merged into one draw, a UI mesh renderer has a single material
+    struct FTriangle
+    {
+        float Depth;
+        int32 FirstIndex;
+    };
+
+    const FIndexArrayView SourceIndices = LOD.IndexBuffer.GetArrayView();
+    TArray<FTriangle> Triangles;
+    Triangles.Reserve(SourceIndices.Num() / 3);
+    for (const FStaticMeshSection& Section : LOD.Sections)
+    {
+        for (uint32 Triangle = 0; Triangle < Section.NumTriangles; ++Triangle)
+        {
+            const int32 FirstIndex = Section.FirstIndex + Triangle * 3;
+            Triangles.Add({ PositionBuffer.VertexPosition(SourceIndices[FirstIndex]).Z, FirstIndex });
+        }
+    }
 
-            for (uint32 i = 0; i < NumVerts; ++i)
-            {
-                // Copy Position
-                const FVector& Position = LOD.VertexBuffers.PositionVertexBuffer.VertexPosition(i);
-                OutExtentMin.X = FMath::Min(Position.X, OutExtentMin.X);
-                OutExtentMin.Y = FMath::Min(Position.Y, OutExtentMin.Y);
-                OutExtentMax.X = FMath::Max(Position.X, OutExtentMax.X);
-                OutExtentMax.Y = FMath::Max(Position.Y, OutExtentMax.Y);
+    // Sort the triangles such that they are drawn in Z-order, assuming every triangle is coplanar with Z == SomeValue.
+    // Triangles at the same depth keep their index buffer order
+    Algo::Sort(Triangles, [](const FTriangle& A, const FTriangle& B)
+    {
+        return A.Depth < B.Depth || (A.Depth == B.Depth && A.FirstIndex < B.FirstIndex);
+    });
 
-                // Copy Color
-                FColor Color = (LOD.VertexBuffers.ColorVertexBuffer.GetNumVertices() > 0) ? LOD.VertexBuffers.ColorVertexBuffer.VertexColor(i) : FColor::White;
+    OutMeshData.Index.SetNumUninitialized(Triangles.Num() * 3);
+    for (int32 Triangle = 0; Triangle < Triangles.Num(); ++Triangle)
+    {
+        for (int32 Corner = 0; Corner < 3; ++Corner)
+        {
+            OutMeshData.Index[Triangle * 3 + Corner] = SourceIndices[Triangles[Triangle].FirstIndex + Corner];
+        }
+    }
 
-                // Copy all the UVs that we have, and as many as we can fit.
-                const FVector2D& UV0 = (TexCoordsPerVertex > 0) ? LOD.VertexBuffers.StaticMeshVertexBuffer.GetVertexUV(i, 0) : FVector2D(1, 1);
+    return NumVerts > 0 && OutMeshData.Index.Num() > 0;
+}
 
-                const FVector2D& UV1 = (TexCoordsPerVertex > 1) ? LOD.VertexBuffers.StaticMeshVertexBuffer.GetVertexUV(i, 1) : FVector2D(1, 1);
+static void GetParticleMeshes(const UNiagaraSystem* NiagaraSystem, TArray<UStaticMesh*, TInlineAllocator<4>>& OutMeshes)
+{
+    if (!NiagaraSystem)
+        return;
 
-                const FVector2D& UV2 = (TexCoordsPerVertex > 2) ? LOD.VertexBuffers.StaticMeshVertexBuffer.GetVertexUV(i, 2) : FVector2D(1, 1);
+    for (const FNiagaraEmitterHandle& EmitterHandle : NiagaraSystem->GetEmitterHandles())
+    {
+        if (!EmitterHandle.GetInstance())
+            continue;
 
-                const FVector2D& UV3 = (TexCoordsPerVertex > 3) ? LOD.VertexBuffers.StaticMeshVertexBuffer.GetVertexUV(i, 3) : FVector2D(1, 1);
+        for (UNiagaraRendererProperties* Renderer : EmitterHandle.GetInstance()->GetRenderers())
+        {
+            UNiagaraMeshRendererProperties* MeshRenderer = Cast<UNiagaraMeshRendererProperties>(Renderer);
+            if (MeshRenderer && MeshRenderer->ParticleMesh)
+            {
+                OutMeshes.AddUnique(MeshRenderer->ParticleMesh);
+            }
+        }
+    }
+}
 
-                const FVector2D& UV4 = (TexCoordsPerVertex > 4) ? LOD.VertexBuffers.StaticMeshVertexBuffer.GetVertexUV(i, 4) : FVector2D(1, 1);
+// Bakes every LOD of the mesh, in LOD order
+static void BakeStaticMesh(const UStaticMesh& StaticMesh, TArray<FSlateMeshData>& OutMeshData)
+{
+    if (!StaticMesh.RenderData.IsValid())
+        return;
 
-                const FVector2D& UV5 = (TexCoordsPerVertex > 5) ? LOD.VertexBuffers.StaticMeshVertexBuffer.GetVertexUV(i, 5) : FVector2D(1, 1);
+    if (!FPlatformProperties::HasEditorOnlyData() && !StaticMesh.bAllowCPUAccess)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("StaticMesh %s can't be baked for the Niagara UI at runtime, enable Allow CPU Access on it or bake it at cook time."), *StaticMesh.GetName());
+        return;
+    }
 
-                OutSlateVerts.Add(FSlateMeshVertex(
-                    FVector2D(Position.X, Position.Y),
-                    Color,
-                    UV0,
-                    UV1,
-                    UV2,
-                    UV3,
-                    UV4,
-                    UV5
-                ));
-            }
+    const FName MeshPackageName = StaticMesh.GetPackage()->GetFName();
+    for (int32 LODIndex = 0; LODIndex < StaticMesh.RenderData->LODResources.Num(); ++LODIndex)
+    {
+        FSlateMeshData Mesh;
+        Mesh.MeshPackageName = MeshPackageName;
+        if (BakeStaticMeshLOD(StaticMesh, LODIndex, Mesh))
+        {
+            OutMeshData.Add(MoveTemp(Mesh));
         }
+    }
+}
 
-        // Populate Index data
-        {
-            FIndexArrayView SourceIndexes = LOD.IndexBuffer.GetArrayView();
-            const int32 NumIndexes = SourceIndexes.Num();
-            OutIndexes.Empty();
-            OutIndexes.Reserve(NumIndexes);
-            for (int32 i = 0; i < NumIndexes; ++i)
-            {
-                OutIndexes.Add(SourceIndexes[i]);
-            }
+#if WITH_EDITOR
+void UNiagaraSystemWidget::BakeSerializedMeshData() const
+{
+    MeshData.Empty();
+    MeshDataHandles.Reset();
 
+    TArray<UStaticMesh*, TInlineAllocator<4>> ParticleMeshes;
+    GetParticleMeshes(NiagaraSystemReference, ParticleMeshes);
+    for (UStaticMesh* StaticMesh : ParticleMeshes)
+    {
+        BakeStaticMesh(*StaticMesh, MeshData);
+    }
+}
+#endif
 
-            // Sort the index buffer such that verts are drawn in Z-order.
-            // Assume that all triangles are coplanar with Z == SomeValue.
-            ensure(NumIndexes % 3 == 0);
-            for (int32 a = 0; a < NumIndexes; a += 3)
-            {
-                for (int32 b = 0; b < NumIndexes; b += 3)
-                {
-                    const float VertADepth = LOD.VertexBuffers.PositionVertexBuffer.VertexPosition(OutIndexes[a]).Z;
-                    const float VertBDepth = LOD.VertexBuffers.PositionVertexBuffer.VertexPosition(OutIndexes[b]).Z;
-                    if (VertADepth < VertBDepth)
-                    {
-                        // Swap the order in which triangles will be drawn
-                        Swap(OutIndexes[a + 0], OutIndexes[b + 0]);
-                        Swap(OutIndexes[a + 1], OutIndexes[b + 1]);
-                        Swap(OutIndexes[a + 2], OutIndexes[b + 2]);
-                    }
-                }
-            }
-        }
+void UNiagaraSystemWidget::ShareSerializedMeshData() const
+{
+    // The editor keeps the baked data for saving and shares copies of it. Freshly baked data replaces what other
+    // widgets hold, so mesh edits show up
+    FNiagaraUIMeshDataCache& Cache = FNiagaraUIMeshDataCache::Get();
+    for (FSlateMeshData& Mesh : MeshData)
+    {
+        TArray<FSlateMeshDataPtr>& LODs = MeshDataHandles.FindOrAdd(Mesh.MeshPackageName);
+        if (LODs.ContainsByPredicate([&](const FSlateMeshDataPtr& LOD) { return LOD->LODIndex == Mesh.LODIndex; }))
+            continue;
+
+        LODs.Add(GIsEditor ? Cache.Add(FSlateMeshData(Mesh), true) : Cache.Add(MoveTemp(Mesh), false));
+    }
+
+    if (!GIsEditor)
+    {
+        MeshData.Empty();
     }
 }
 
-void UNiagaraSystemWidget::ValidateCompiledDefaults(class IWidgetCompilerLog& CompileLog) const
+void UNiagaraSystemWidget::AcquireMeshData() const
 {
-    Super::ValidateCompiledDefaults(CompileLog);
+    ShareSerializedMeshData();
 
-    MeshData.Empty();
-    for (auto i : NiagaraSystemReference->GetEmitterHandles())
+    TArray<UStaticMesh*, TInlineAllocator<4>> ParticleMeshes;
+    GetParticleMeshes(NiagaraSystemReference, ParticleMeshes);
+
+    FNiagaraUIMeshDataCache& Cache = FNiagaraUIMeshDataCache::Get();
+    for (UStaticMesh* StaticMesh : ParticleMeshes)
     {
-        for (auto j : i.GetInstance()->GetRenderers())
+        const FName MeshPackageName = StaticMesh->GetPackage()->GetFName();
+        if (MeshDataHandles.Contains(MeshPackageName))
+            continue;
+
+        // Meshes which can't be baked stay in the map without any LOD, so they aren't tried again every time
+        TArray<FSlateMeshDataPtr>& LODs = MeshDataHandles.Add(MeshPackageName);
+        // LODs which failed to bake leave gaps in the cached indices
+        for (int32 LODIndex = 0; LODIndex < StaticMesh->GetNumLODs(); ++LODIndex)
         {
-            if (UNiagaraMeshRendererProperties* MeshRenderer = Cast<UNiagaraMeshRendererProperties>(j))
+            if (FSlateMeshDataPtr SharedLOD = Cache.Find(MeshPackageName, LODIndex))
             {
-                if (MeshRenderer->ParticleMesh)
-                {
-                    TArray<FSlateMeshVertex> SlateVerts;
-                    TArray<uint32> Indexes;
-                    FVector2D ExtentMin;
-                    FVector2D ExtentMax;
-                    StaticMeshToSlateRenderData(*MeshRenderer->ParticleMesh, SlateVerts, Indexes, ExtentMin, ExtentMax);
-                    FSlateMeshData Mesh;
-                    Mesh.MeshPackageName = MeshRenderer->ParticleMesh->GetPackage()->GetFName();
-                    Mesh.Vertex.Empty(SlateVerts.Num());
-                    Mesh.VertexColor.Empty(SlateVerts.Num());
-                    Mesh.UV.Empty(SlateVerts.Num());
-                    for (auto k : SlateVerts)
-                    {
-                        Mesh.Vertex.Add(k.Position);
-                        Mesh.VertexColor.Add(k.Color);
-                        Mesh.UV.Add(k.UV0);
-                    }
-                    Mesh.Index = Indexes;
-                    MeshData.Add(Mesh);
-                }
-                
+                LODs.Add(SharedLOD);
             }
         }
+
+        if (LODs.Num() > 0)
+            continue;
+
+        TArray<FSlateMeshData> BakedLODs;
+        BakeStaticMesh(*StaticMesh, BakedLODs);
+        for (FSlateMeshData& BakedLOD : BakedLODs)
+        {
+            LODs.Add(Cache.Add(MoveTemp(BakedLOD), true));
+        }
     }
-        
 }
-#endif
+
+const TArray<FSlateMeshDataPtr>* UNiagaraSystemWidget::FindMeshData(FName MeshPackageName) const
+{
+    const TArray<FSlateMeshDataPtr>* LODs = MeshDataHandles.Find(MeshPackageName);
+    return LODs && LODs->Num() > 0 ? LODs : nullptr;
+}
 
 void UNiagaraSystemWidget::InitializeNiagaraUI()
 {
@@ -210,23 +319,67 @@ void UNiagaraSystemWidget::InitializeNiagaraUI()
 		if (!World->PersistentLevel)
 			return;
 
+		AcquireMeshData();
+
 		if (!NiagaraComponent)
 		{
-			NiagaraComponent = NewObject<UNiagaraUIComponent>(this);
-            NiagaraComponent->SetAutoActivate(AutoActivate);
-            NiagaraComponent->SetHiddenInGame(!ShowDebugSystemInWorld);
-            NiagaraComponent->RegisterComponentWithWorld(World);
-            NiagaraComponent->SetAsset(NiagaraSystemReference);
-            NiagaraComponent->SetAutoDestroy(false);
-           
-            if (TickWhenPaused)
-            {
-				NiagaraComponent->PrimaryComponentTick.bTickEvenWhenPaused = true;
-				NiagaraComponent->SetForceSolo(true);
-            }
+			if (ShareSimulation)
+			{
+				// The shared component outlives this widget, so it's owned by the world
+				NiagaraComponent = FNiagaraUISharedSimulations::Get().Acquire(World, NiagaraSystemReference, AutoActivate, TickWhenPaused, SimulationRate, [this, World]() { return CreateNiagaraComponent(World, World); });
+				UsesSharedSimulation = true;
+			}
+			else
+			{
+				NiagaraComponent = CreateNiagaraComponent(this, World);
+			}
+		}
+
+		// The asynchronous generation follows a single widget, the widgets sharing a simulation are generated while painting
+		NiagaraSlateWidget->SetNiagaraComponentReference(NiagaraComponent, FNiagaraWidgetProperties(AutoActivate, ShowDebugSystemInWorld, FakeDepthScale, FakeDepthScaleDistance, AsyncGeneration && !UsesSharedSimulation, BudgetPriority));
+	}
+}
+
+UNiagaraUIComponent* UNiagaraSystemWidget::CreateNiagaraComponent(UObject* Outer, UWorld* World)
+{
+	// Simulations prewarmed for the system are already running, so they're only taken by auto activated widgets
+	UNiagaraUIPrewarmSubsystem* PrewarmSubsystem = World->GetSubsystem<UNiagaraUIPrewarmSubsystem>();
+	if (AutoActivate && PrewarmSubsystem)
+	{
+		if (UNiagaraUIComponent* PrewarmedComponent = PrewarmSubsystem->ClaimPrewarmed(NiagaraSystemReference, TickWhenPaused))
+		{
+			PrewarmedComponent->SetHiddenInGame(!ShowDebugSystemInWorld);
+			return PrewarmedComponent;
 		}
-		NiagaraSlateWidget->SetNiagaraComponentReference(NiagaraComponent, FNiagaraWidgetProperties(AutoActivate, ShowDebugSystemInWorld, FakeDepthScale, FakeDepthScaleDistance));
 	}
+
+	UNiagaraUIComponent* NewComponent = NewObject<UNiagaraUIComponent>(Outer);
+	NewComponent->SetAutoActivate(AutoActivate);
+	NewComponent->SetHiddenInGame(!ShowDebugSystemInWorld);
+	NewComponent->RegisterComponentWithWorld(World);
+	NewComponent->SetAsset(NiagaraSystemReference);
+	NewComponent->SetAutoDestroy(false);
+
+	if (TickWhenPaused)
+	{
+		NewComponent->PrimaryComponentTick.bTickEvenWhenPaused = true;
+		NewComponent->SetForceSolo(true);
+	}
+
+	NewComponent->SetSimulationRate(SimulationRate);
+	return NewComponent;
+}
+
+void UNiagaraSystemWidget::ReleaseSharedSimulation()
+{
+	if (!UsesSharedSimulation)
+		return;
+
+	if (NiagaraComponent)
+		FNiagaraUISharedSimulations::Get().Release(NiagaraComponent);
+
+	NiagaraComponent = nullptr;
+	UsesSharedSimulation = false;
 }
 
 void UNiagaraSystemWidget::ActivateSystem(bool Reset)
@@ -250,9 +403,33 @@ void UNiagaraSystemWidget::UpdateNiagaraSystemReference(UNiagaraSystem* NewNiaga
 {
 	NiagaraSystemReference = NewNiagaraSystem;
 
+	// Generation in flight reads the meshes of the previous system
+	if (NiagaraComponent && NiagaraSlateWidget.IsValid())
+	{
+		NiagaraComponent->ReleaseAsyncWidget(NiagaraSlateWidget.Get());
+	}
+
+	// Systems swapped at runtime keep their mesh renderers. The previous handles may be the only references to LODs
+	// shared from cooked data, which can't be baked again, so they're held until the new system found its LODs in the cache
+	const TMap<FName, TArray<FSlateMeshDataPtr>> PreviousMeshDataHandles = MoveTemp(MeshDataHandles);
+	MeshDataHandles.Reset();
+	AcquireMeshData();
+
+	// Other widgets keep the previous system, this one subscribes to the simulation of the new one
+	if (UsesSharedSimulation)
+	{
+		ReleaseSharedSimulation();
+		if (NiagaraSlateWidget.IsValid())
+		{
+			InitializeNiagaraUI();
+		}
+		return;
+	}
+
 	if (NiagaraComponent)
 	{
 		NiagaraComponent->SetAsset(NewNiagaraSystem);
+		NiagaraComponent->InvalidateRendererCache();
 		NiagaraComponent->ResetSystem();
 	}
 }
@@ -261,10 +438,20 @@ void UNiagaraSystemWidget::UpdateTickWhenPaused(bool NewTickWhenPaused)
 {
 	TickWhenPaused = NewTickWhenPaused;
 
+	if (UsesSharedSimulation)
+	{
+		ReleaseSharedSimulation();
+		if (NiagaraSlateWidget.IsValid())
+		{
+			InitializeNiagaraUI();
+		}
+		return;
+	}
+
 	if (NiagaraComponent)
 	{
 		NiagaraComponent->SetTickableWhenPaused(NewTickWhenPaused);
-		NiagaraComponent->SetForceSolo(NewTickWhenPaused);
+		NiagaraComponent->SetForceSolo(NewTickWhenPaused || SimulationRate > 0.f);
 		NiagaraComponent->ResetSystem();
 	}
 }
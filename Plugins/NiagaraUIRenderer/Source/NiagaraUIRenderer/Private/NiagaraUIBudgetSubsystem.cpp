@@ -0,0 +1,163 @@
+// Copyright 2021 - Michal Smoleň
+
+#include "NiagaraUIBudgetSubsystem.h"
+#include "NiagaraUIComponent.h"
+#include "NiagaraUIStats.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Budget Particles"), STAT_NiagaraUIBudgetParticles, STATGROUP_NiagaraUI);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Budget Particle Demand"), STAT_NiagaraUIBudgetDemand, STATGROUP_NiagaraUI);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Budget Generate Time (ms)"), STAT_NiagaraUIBudgetGenerateTime, STATGROUP_NiagaraUI);
+
+static TAutoConsoleVariable<int32> CVarNiagaraUIBudgetMaxParticles(
+	TEXT("NiagaraUI.Budget.MaxParticles"),
+	0,
+	TEXT("Maximum number of particles all Niagara UI widgets of a world render together. 0 disables the limit."),
+	ECVF_Scalability);
+
+static TAutoConsoleVariable<float> CVarNiagaraUIBudgetMaxGenerateTimeMs(
+	TEXT("NiagaraUI.Budget.MaxGenerateTimeMs"),
+	0.f,
+	TEXT("Generation time in milliseconds per frame all Niagara UI widgets of a world should stay under. The particle budget follows the measured time. 0 disables the limit."),
+	ECVF_Scalability);
+
+// The time controlled budget never drops below this, so effects don't vanish completely
+static const float MinParticleBudget = 64.f;
+
+// Largest change of the time controlled budget per frame
+static const float MinBudgetStep = 0.8f;
+static const float MaxBudgetStep = 1.25f;
+
+// Weight of the new frame in the smoothed generation time
+static const float GenerateTimeSmoothing = 0.2f;
+
+void UNiagaraUIBudgetSubsystem::Deinitialize()
+{
+	Components.Reset();
+
+	Super::Deinitialize();
+}
+
+void UNiagaraUIBudgetSubsystem::RegisterComponent(UNiagaraUIComponent* Component)
+{
+	Components.AddUnique(Component);
+}
+
+void UNiagaraUIBudgetSubsystem::UnregisterComponent(UNiagaraUIComponent* Component)
+{
+	Components.RemoveSwap(Component);
+}
+
+ETickableTickType UNiagaraUIBudgetSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+bool UNiagaraUIBudgetSubsystem::IsTickable() const
+{
+	return Components.Num() > 0;
+}
+
+TStatId UNiagaraUIBudgetSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UNiagaraUIBudgetSubsystem, STATGROUP_NiagaraUI);
+}
+
+void UNiagaraUIBudgetSubsystem::Tick(float DeltaTime)
+{
+	struct FComponentUsage
+	{
+		UNiagaraUIComponent* Component;
+		FNiagaraUIBudgetUsage Usage;
+		float Weight;
+	};
+
+	TArray<FComponentUsage, TInlineAllocator<32>> Usages;
+	int32 TotalDemand = 0;
+	uint32 TotalGenerateCycles = 0;
+	for (int32 Index = Components.Num() - 1; Index >= 0; --Index)
+	{
+		UNiagaraUIComponent* Component = Components[Index].Get();
+		if (!Component)
+		{
+			Components.RemoveAtSwap(Index, 1, false);
+			continue;
+		}
+
+		FComponentUsage& ComponentUsage = Usages.AddDefaulted_GetRef();
+		ComponentUsage.Component = Component;
+		ComponentUsage.Usage = Component->ConsumeBudgetUsage();
+		ComponentUsage.Weight = ComponentUsage.Usage.Priority * FMath::Max(ComponentUsage.Usage.VisibleArea, 1.f);
+		TotalDemand += ComponentUsage.Usage.Particles;
+		TotalGenerateCycles += ComponentUsage.Usage.GenerateCycles;
+	}
+
+	const int32 MaxParticles = CVarNiagaraUIBudgetMaxParticles.GetValueOnGameThread();
+	const float MaxGenerateTimeMs = CVarNiagaraUIBudgetMaxGenerateTimeMs.GetValueOnGameThread();
+
+	const float GenerateTimeMs = FPlatformTime::ToMilliseconds(TotalGenerateCycles);
+	SmoothedGenerateTimeMs = FMath::Lerp(SmoothedGenerateTimeMs, GenerateTimeMs, GenerateTimeSmoothing);
+	SET_DWORD_STAT(STAT_NiagaraUIBudgetDemand, TotalDemand);
+	SET_FLOAT_STAT(STAT_NiagaraUIBudgetGenerateTime, GenerateTimeMs);
+
+	if (MaxParticles <= 0 && MaxGenerateTimeMs <= 0.f)
+	{
+		ParticleBudget = 0.f;
+		for (const FComponentUsage& ComponentUsage : Usages)
+		{
+			ComponentUsage.Component->SetParticleBudget(MAX_int32);
+		}
+		SET_DWORD_STAT(STAT_NiagaraUIBudgetParticles, 0);
+		return;
+	}
+
+	if (MaxGenerateTimeMs > 0.f)
+	{
+		if (ParticleBudget <= 0.f)
+		{
+			ParticleBudget = FMath::Max((float)TotalDemand, MinParticleBudget);
+		}
+
+		// Proportional control on the generation time. The budget doesn't wind up past the demand, so it reacts at once
+		// when more effects show up
+		if (SmoothedGenerateTimeMs > KINDA_SMALL_NUMBER)
+		{
+			ParticleBudget *= FMath::Clamp(MaxGenerateTimeMs / SmoothedGenerateTimeMs, MinBudgetStep, MaxBudgetStep);
+		}
+		ParticleBudget = FMath::Clamp(ParticleBudget, MinParticleBudget, FMath::Max((float)TotalDemand * MaxBudgetStep, MinParticleBudget));
+	}
+	else
+	{
+		ParticleBudget = (float)MaxParticles;
+	}
+
+	if (MaxParticles > 0)
+	{
+		ParticleBudget = FMath::Min(ParticleBudget, (float)MaxParticles);
+	}
+	SET_DWORD_STAT(STAT_NiagaraUIBudgetParticles, GetParticleBudget());
+
+	// Weighted max-min split, components which need less than their share give the rest to the others
+	Usages.Sort([](const FComponentUsage& A, const FComponentUsage& B)
+	{
+		return A.Usage.Particles * B.Weight < B.Usage.Particles * A.Weight;
+	});
+
+	float RemainingBudget = ParticleBudget;
+	float RemainingWeight = 0.f;
+	for (const FComponentUsage& ComponentUsage : Usages)
+	{
+		RemainingWeight += ComponentUsage.Weight;
+	}
+
+	for (int32 Index = 0; Index < Usages.Num(); ++Index)
+	{
+		const FComponentUsage& ComponentUsage = Usages[Index];
+		const float Share = RemainingWeight > KINDA_SMALL_NUMBER ? RemainingBudget * ComponentUsage.Weight / RemainingWeight : RemainingBudget / (Usages.Num() - Index);
+		const float Allocation = FMath::Min((float)ComponentUsage.Usage.Particles, Share);
+
+		ComponentUsage.Component->SetParticleBudget(FMath::FloorToInt(Share));
+		RemainingBudget = FMath::Max(RemainingBudget - Allocation, 0.f);
+		RemainingWeight -= ComponentUsage.Weight;
+	}
+}
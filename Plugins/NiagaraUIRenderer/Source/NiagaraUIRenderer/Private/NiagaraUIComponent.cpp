@@ -3,19 +3,113 @@
 #include "NiagaraUIComponent.h"
 #include "Stats/Stats.h"
 #include "NiagaraRenderer.h"
+#include "NiagaraSystem.h"
+#include "NiagaraConstants.h"
 #include "NiagaraRibbonRendererProperties.h"
 #include "NiagaraSpriteRendererProperties.h"
 #include "NiagaraMeshRendererProperties.h"
-#include "Slate/SlateVectorArtInstanceData.h"
+#include "Materials/MaterialInterface.h"
 #include "NiagaraSystemWidget.h"
+#include "NiagaraUIParticleStreams.h"
+#include "NiagaraUIInstancePacking.h"
+#include "NiagaraUIParticleSort.h"
+#include "NiagaraUIParticleInterpolation.h"
+#include "HAL/IConsoleManager.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
 #include "SNiagaraUISystemWidget.h"
+#include "NiagaraUIStats.h"
+#include "NiagaraUIBudgetSubsystem.h"
 
-
-DECLARE_STATS_GROUP(TEXT("NiagaraUI"), STATGROUP_NiagaraUI, STATCAT_Advanced);
 DECLARE_CYCLE_STAT(TEXT("Generate Sprite Data"), STAT_GenerateSpriteData, STATGROUP_NiagaraUI);
 DECLARE_CYCLE_STAT(TEXT("Generate Ribbon Data"), STAT_GenerateRibbonData, STATGROUP_NiagaraUI);
+DECLARE_CYCLE_STAT(TEXT("Sort Particles"), STAT_NiagaraUISortParticles, STATGROUP_NiagaraUI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Culled Sprites"), STAT_NiagaraUICulledSprites, STATGROUP_NiagaraUI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Culled Meshes"), STAT_NiagaraUICulledMeshes, STATGROUP_NiagaraUI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Culled Ribbon Segments"), STAT_NiagaraUICulledRibbonSegments, STATGROUP_NiagaraUI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Culled Renderers"), STAT_NiagaraUICulledRenderers, STATGROUP_NiagaraUI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Budget Truncated Particles"), STAT_NiagaraUIBudgetTruncatedParticles, STATGROUP_NiagaraUI);
+
+static TAutoConsoleVariable<int32> CVarNiagaraUISIMDPacking(
+    TEXT("NiagaraUI.SIMDPacking"),
+    1,
+    TEXT("Pack the sprite and mesh instance data four particles at a time. 0 falls back to the scalar packing."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarNiagaraUIParallelInstanceThreshold(
+    TEXT("NiagaraUI.ParallelInstanceThreshold"),
+    4096,
+    TEXT("Sprite and mesh emitters with at least this many particles generate their instances in parallel chunks. 0 disables the parallel path."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarNiagaraUIParallelRenderers(
+    TEXT("NiagaraUI.ParallelRenderers"),
+    1,
+    TEXT("Generate the geometry of every renderer of a UI system in its own task."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarNiagaraUICullAlphaThreshold(
+    TEXT("NiagaraUI.CullAlphaThreshold"),
+    1.f / 255.f,
+    TEXT("Particles and ribbon segments with a lower alpha are not rendered."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarNiagaraUICullMinPixelSize(
+    TEXT("NiagaraUI.CullMinPixelSize"),
+    1.f,
+    TEXT("Particles and ribbon segments smaller than this many pixels are not rendered."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarNiagaraUIMeshLODReferenceHeight(
+    TEXT("NiagaraUI.MeshLODReferenceHeight"),
+    1080.f,
+    TEXT("Height in slate units the static mesh LOD screen sizes of UI particle meshes are relative to."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarNiagaraUISuspendAfterFrames(
+    TEXT("NiagaraUI.SuspendAfterFrames"),
+    5,
+    TEXT("Pause the simulation of UI particle systems whose widget wasn't painted for this many frames, like collapsed, hidden or scrolled out widgets. 0 keeps them simulating."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarNiagaraUIResumeCatchUpSeconds(
+    TEXT("NiagaraUI.ResumeCatchUpSeconds"),
+    0.f,
+    TEXT("Suspended UI particle systems fast-forward the time they were suspended, up to this many seconds, when their widget is painted again. 0 continues where they were paused."),
+    ECVF_Default);
+
+// Step of the fast-forward when a suspended system resumes
+static const float ResumeCatchUpTickSeconds = 1.f / 30.f;
+
+// User parameter systems can multiply their spawn rates with to follow the UI particle budget
+static const FName BudgetSpawnScaleParameterName(TEXT("NiagaraUISpawnScale"));
+static const FName BudgetSpawnScaleUserParameterName(TEXT("User.NiagaraUISpawnScale"));
+
+// Lowest spawn scale the budget sets, and the largest change of it per budget update
+static const float MinBudgetSpawnScale = 0.05f;
+static const float MinBudgetSpawnScaleStep = 0.5f;
+static const float MaxBudgetSpawnScaleStep = 1.1f;
+
+// Material scalar parameter selecting the ENiagaraUIInstanceFormat the material decodes
+static const FName InstanceFormatParameterName(TEXT("NiagaraUIInstanceFormat"));
+
+static ENiagaraUIInstanceFormat GetMaterialInstanceFormat(const UMaterialInterface* Material)
+{
+	float Format = 0.f;
+	if (!Material || !Material->GetScalarParameterValue(FMaterialParameterInfo(InstanceFormatParameterName), Format))
+		return ENiagaraUIInstanceFormat::Compact;
+
+	return FMath::RoundToInt(Format) == (int32)ENiagaraUIInstanceFormat::Wide ? ENiagaraUIInstanceFormat::Wide : ENiagaraUIInstanceFormat::Compact;
+}
+
+void UNiagaraUIComponent::Activate(bool bReset)
+{
+    Super::Activate(bReset);
 
-PRAGMA_DISABLE_OPTIMIZATION
+    // Widgets which are never painted get the same grace period as widgets which stopped being painted
+    LastPaintFrame = GFrameCounter;
+    PresizeRenderDataPending = true;
+}
 
 void UNiagaraUIComponent::SetTransformationForUIRendering(const FTransform& Transform)
 {
@@ -25,65 +119,679 @@ void UNiagaraUIComponent::SetTransformationForUIRendering(const FTransform& Tran
     {
         ActivateSystem();
         bAutoActivate = false;
+        PresizeRenderDataPending = true;
     }
 }
 
-struct FNiagaraRendererEntry
+void UNiagaraUIComponent::InvalidateRendererCache()
 {
-	FNiagaraRendererEntry(UNiagaraRendererProperties* PropertiesIn, TSharedRef<const FNiagaraEmitterInstance, ESPMode::ThreadSafe> EmitterInstIn, UNiagaraEmitter* EmitterIn)
-		: RendererProperties(PropertiesIn), EmitterInstance(EmitterInstIn), Emitter(EmitterIn) {}
-	UNiagaraRendererProperties* RendererProperties;
-	TSharedRef<const FNiagaraEmitterInstance, ESPMode::ThreadSafe> EmitterInstance;
-	UNiagaraEmitter* Emitter;
-};
+	RendererCacheDirty = true;
+}
 
-void UNiagaraUIComponent::RenderUI(SNiagaraUISystemWidget* NiagaraWidget, const FSlateLayoutTransform& SlateLayoutTransform, const FTransform& ComponentTransform, const FNiagaraWidgetProperties* WidgetProperties)
+bool UNiagaraUIComponent::IsRendererCacheValid() const
 {
-	if (!IsActive())
+	if (RendererCacheDirty || CachedRenderersSystemInstance != GetSystemInstance())
+		return false;
+
+	// Emitter instances are recreated when the system instance gets reinitialized
+	const auto& Emitters = GetSystemInstance()->GetEmitters();
+	for (const FNiagaraUIRendererEntry& Renderer : CachedRenderers)
+	{
+		if (!Emitters.IsValidIndex(Renderer.EmitterIndex) || &Emitters[Renderer.EmitterIndex].Get() != &Renderer.EmitterInstance.Get())
+			return false;
+	}
+
+	return true;
+}
+
+void UNiagaraUIComponent::BuildRendererCache()
+{
+	CachedRenderers.Reset();
+	CachedRenderersSystemInstance = GetSystemInstance();
+	RendererCacheDirty = false;
+
+#if WITH_EDITOR
+	if (CompileDelegateSystem != GetAsset())
+	{
+		if (UNiagaraSystem* PreviousSystem = CompileDelegateSystem.Get())
+			PreviousSystem->OnSystemCompiled().RemoveAll(this);
+
+		CompileDelegateSystem = GetAsset();
+
+		if (UNiagaraSystem* NewSystem = CompileDelegateSystem.Get())
+			NewSystem->OnSystemCompiled().AddUObject(this, &UNiagaraUIComponent::OnSystemCompiled);
+	}
+#endif
+
+	const auto& Emitters = GetSystemInstance()->GetEmitters();
+	for (int32 EmitterIndex = 0; EmitterIndex < Emitters.Num(); ++EmitterIndex)
+	{
+		UNiagaraEmitter* Emitter = Emitters[EmitterIndex]->GetCachedEmitter();
+		if (!Emitter || Emitter->SimTarget != ENiagaraSimTarget::CPUSim)
+			continue;
+
+		for (UNiagaraRendererProperties* Property : Emitter->GetRenderers())
+		{
+			if (!Property || !Property->IsSimTargetSupported(Emitter->SimTarget))
+				continue;
+
+			if (UNiagaraSpriteRendererProperties* SpriteRenderer = Cast<UNiagaraSpriteRendererProperties>(Property))
+			{
+				FNiagaraUIRendererEntry& Entry = CachedRenderers.Emplace_GetRef(ENiagaraUIRendererType::Sprite, Property, Emitters[EmitterIndex], EmitterIndex);
+				Entry.InstanceFormat = GetMaterialInstanceFormat(SpriteRenderer->Material);
+			}
+			else if (Property->IsA<UNiagaraRibbonRendererProperties>())
+			{
+				CachedRenderers.Emplace(ENiagaraUIRendererType::Ribbon, Property, Emitters[EmitterIndex], EmitterIndex);
+			}
+			else if (UNiagaraMeshRendererProperties* MeshRenderer = Cast<UNiagaraMeshRendererProperties>(Property))
+			{
+				FNiagaraUIRendererEntry& Entry = CachedRenderers.Emplace_GetRef(ENiagaraUIRendererType::Mesh, Property, Emitters[EmitterIndex], EmitterIndex);
+				if (MeshRenderer->OverrideMaterials.Num() > 0)
+				{
+					Entry.InstanceFormat = GetMaterialInstanceFormat(MeshRenderer->OverrideMaterials[0].ExplicitMat);
+				}
+			}
+		}
+	}
+
+	Algo::Sort(CachedRenderers, [] (const FNiagaraUIRendererEntry& FirstElement, const FNiagaraUIRendererEntry& SecondElement) {return FirstElement.RendererProperties->SortOrderHint < SecondElement.RendererProperties->SortOrderHint;});
+}
+
+#if WITH_EDITOR
+void UNiagaraUIComponent::OnSystemCompiled(UNiagaraSystem* System)
+{
+	InvalidateRendererCache();
+}
+#endif
+
+void UNiagaraUIComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	// With a reduced simulation rate the component ticks once per simulation step, the state before the step is kept
+	// for the interpolation
+	if (SimulationInterval > 0.f)
+	{
+		CapturePreviousParticleData();
+		LastSimulationTime = GetClockSeconds();
+	}
+
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	// Widgets which aren't painted don't need their particles, the simulation waits for the next paint
+	const int32 SuspendAfterFrames = CVarNiagaraUISuspendAfterFrames.GetValueOnGameThread();
+	if (SuspendWhileHidden && !SuspendedWhileHidden && SuspendAfterFrames > 0 && GFrameCounter - LastPaintFrame > (uint64)SuspendAfterFrames && IsActive() && !IsPaused())
+	{
+		SetPaused(true);
+		SuspendedWhileHidden = true;
+		SuspendedTime = GetClockSeconds();
+	}
+}
+
+void UNiagaraUIComponent::SetSuspendWhileHidden(bool Enabled)
+{
+	SuspendWhileHidden = Enabled;
+	LastPaintFrame = GFrameCounter;
+}
+
+void UNiagaraUIComponent::ResumeIfSuspended()
+{
+	if (!SuspendedWhileHidden)
+		return;
+
+	SuspendedWhileHidden = false;
+	SetPaused(false);
+
+	const float CatchUpSeconds = FMath::Min((float)(GetClockSeconds() - SuspendedTime), CVarNiagaraUIResumeCatchUpSeconds.GetValueOnGameThread());
+	const int32 CatchUpTicks = FMath::FloorToInt(CatchUpSeconds / ResumeCatchUpTickSeconds);
+	if (CatchUpTicks > 0)
+	{
+		AdvanceSimulation(CatchUpTicks, ResumeCatchUpTickSeconds);
+	}
+}
+
+double UNiagaraUIComponent::GetClockSeconds() const
+{
+	const UWorld* World = GetWorld();
+	if (!World)
+		return 0.0;
+
+	return PrimaryComponentTick.bTickEvenWhenPaused ? World->GetUnpausedTimeSeconds() : World->GetTimeSeconds();
+}
+
+void UNiagaraUIComponent::SetSimulationRate(float RateHz)
+{
+	const float NewInterval = RateHz > 0.f ? 1.f / RateHz : 0.f;
+	if (NewInterval == SimulationInterval)
+		return;
+
+	SimulationInterval = NewInterval;
+	SetComponentTickInterval(SimulationInterval);
+
+	// Only solo instances are simulated by the component tick, batched ones follow their system simulation every frame
+	SetForceSolo(SimulationInterval > 0.f || PrimaryComponentTick.bTickEvenWhenPaused);
+
+	if (SimulationInterval <= 0.f)
+	{
+		ReleasePreviousParticleData();
+	}
+}
+
+void UNiagaraUIComponent::CapturePreviousParticleData()
+{
+	ReleasePreviousParticleData();
+
+	FNiagaraSystemInstance* SystemInstance = GetSystemInstance();
+	if (!SystemInstance)
+		return;
+
+	SystemInstance->WaitForAsyncTickAndFinalize();
+
+	// The read references keep the buffers from being simulated into, the emitter references keep their data sets alive
+	const auto& Emitters = SystemInstance->GetEmitters();
+	PreviousParticleData.SetNum(Emitters.Num());
+	for (int32 EmitterIndex = 0; EmitterIndex < Emitters.Num(); ++EmitterIndex)
+	{
+		const FNiagaraDataSet& DataSet = Emitters[EmitterIndex]->GetData();
+		if (!DataSet.IsCurrentDataValid())
+			continue;
+
+		FNiagaraUIPreviousParticleData& Previous = PreviousParticleData[EmitterIndex];
+		Previous.EmitterInstance = Emitters[EmitterIndex];
+		Previous.DataBuffer = DataSet.GetCurrentData();
+		Previous.DataBuffer->AddReadRef();
+	}
+}
+
+void UNiagaraUIComponent::ReleasePreviousParticleData()
+{
+	for (FNiagaraUIPreviousParticleData& Previous : PreviousParticleData)
+	{
+		if (Previous.DataBuffer)
+		{
+			Previous.DataBuffer->ReleaseReadRef();
+		}
+	}
+	PreviousParticleData.Reset();
+}
+
+void UNiagaraUIComponent::OnRegister()
+{
+	Super::OnRegister();
+
+	if (UWorld* World = GetWorld())
+	{
+		if (UNiagaraUIBudgetSubsystem* BudgetSubsystem = World->GetSubsystem<UNiagaraUIBudgetSubsystem>())
+		{
+			BudgetSubsystem->RegisterComponent(this);
+		}
+	}
+}
+
+void UNiagaraUIComponent::OnUnregister()
+{
+	if (UWorld* World = GetWorld())
+	{
+		if (UNiagaraUIBudgetSubsystem* BudgetSubsystem = World->GetSubsystem<UNiagaraUIBudgetSubsystem>())
+		{
+			BudgetSubsystem->UnregisterComponent(this);
+		}
+	}
+
+	WaitForAsyncGeneration();
+	ReleaseRendererJobs();
+	ReleasePreviousParticleData();
+	AsyncGenerationPending = false;
+	AsyncWidget = nullptr;
+
+	if (GenerateTickFunction.IsTickFunctionRegistered())
+	{
+		GenerateTickFunction.UnRegisterTickFunction();
+	}
+
+	Super::OnUnregister();
+}
+
+void UNiagaraUIComponent::RenderUI(SNiagaraUISystemWidget* NiagaraWidget, const FSlateLayoutTransform& SlateLayoutTransform, const FTransform& ComponentTransform, const FNiagaraWidgetProperties* WidgetProperties, const FSlateRect& CullingRect)
+{
+	BudgetUsage.Priority = WidgetProperties->BudgetPriority;
+
+	LastPaintFrame = GFrameCounter;
+	ResumeIfSuspended();
+
+	if (WidgetProperties->AsyncGeneration)
+	{
+		if (AsyncWidget != NiagaraWidget)
+		{
+			ReleaseAsyncWidget(AsyncWidget);
+			AsyncWidget = NiagaraWidget;
+		}
+
+		AsyncLayoutTransform = SlateLayoutTransform;
+		AsyncComponentTransform = ComponentTransform;
+		AsyncWidgetProperties = *WidgetProperties;
+		AsyncCullingRect = CullingRect;
+
+		if (!GenerateTickFunction.IsTickFunctionRegistered() && GetWorld())
+		{
+			GenerateTickFunction.Owner = this;
+			GenerateTickFunction.bCanEverTick = true;
+			GenerateTickFunction.TickGroup = TG_PostUpdateWork;
+			GenerateTickFunction.RegisterTickFunction(GetWorld()->PersistentLevel);
+			GenerateTickFunction.AddPrerequisite(this, PrimaryComponentTick);
+		}
+		GenerateTickFunction.bTickEvenWhenPaused = PrimaryComponentTick.bTickEvenWhenPaused;
+
+		// Swap in the last finished frame, a frame still in flight is picked up by the next paint
+		const bool AsyncGenerationComplete = !AsyncGenerateTasks.ContainsByPredicate([](const FGraphEventRef& Task) { return !Task->IsComplete(); });
+		if (AsyncGenerationPending && AsyncGenerationComplete)
+		{
+			AsyncGenerateTasks.Reset();
+			AsyncGenerationPending = false;
+			SubmitRendererJobs(NiagaraWidget);
+		}
+		return;
+	}
+
+	if (AsyncWidget == NiagaraWidget)
+	{
+		ReleaseAsyncWidget(NiagaraWidget);
+	}
+
+	if (!ReserveRendererJobs(NiagaraWidget, false, SlateLayoutTransform, ComponentTransform, CullingRect))
+		return;
+
+	if (RendererJobs.Num() > 1 && CVarNiagaraUIParallelRenderers.GetValueOnGameThread())
+	{
+		// Every renderer but the last one gets its own task, the last one is generated here while waiting
+		FGraphEventArray GenerateTasks;
+		for (int32 JobIndex = 0; JobIndex < RendererJobs.Num() - 1; ++JobIndex)
+		{
+			FNiagaraUIRendererJob* Job = &RendererJobs[JobIndex];
+			GenerateTasks.Add(FFunctionGraphTask::CreateAndDispatchWhenReady([this, NiagaraWidget, Job, &SlateLayoutTransform, &ComponentTransform, WidgetProperties]()
+			{
+				GenerateRendererData(NiagaraWidget, *Job, SlateLayoutTransform, ComponentTransform, WidgetProperties);
+			}, TStatId(), nullptr, ENamedThreads::AnyThread));
+		}
+
+		GenerateRendererData(NiagaraWidget, RendererJobs.Last(), SlateLayoutTransform, ComponentTransform, WidgetProperties);
+		FTaskGraphInterface::Get().WaitUntilTasksComplete(GenerateTasks);
+	}
+	else
+	{
+		for (FNiagaraUIRendererJob& Job : RendererJobs)
+		{
+			GenerateRendererData(NiagaraWidget, Job, SlateLayoutTransform, ComponentTransform, WidgetProperties);
+		}
+	}
+
+	SubmitRendererJobs(NiagaraWidget);
+}
+
+void UNiagaraUIComponent::StartAsyncGeneration()
+{
+	if (!AsyncWidget)
+		return;
+
+	// The widget wasn't painted since the last generation, there's no point in generating another frame
+	if (AsyncGenerationPending)
+		return;
+
+	if (FNiagaraSystemInstance* SystemInstance = GetSystemInstance())
+	{
+		SystemInstance->WaitForAsyncTickAndFinalize();
+	}
+
+	if (!ReserveRendererJobs(AsyncWidget, true, AsyncLayoutTransform, AsyncComponentTransform, AsyncCullingRect))
+		return;
+
+	// The tasks get their own copy of the transformation, paints keep updating it while they run
+	SNiagaraUISystemWidget* NiagaraWidget = AsyncWidget;
+	const FSlateLayoutTransform LayoutTransform = AsyncLayoutTransform;
+	const FTransform ComponentTransform = AsyncComponentTransform;
+	const FNiagaraWidgetProperties WidgetProperties = AsyncWidgetProperties;
+
+	for (FNiagaraUIRendererJob& Job : RendererJobs)
+	{
+		FNiagaraUIRendererJob* JobPtr = &Job;
+		AsyncGenerateTasks.Add(FFunctionGraphTask::CreateAndDispatchWhenReady([this, NiagaraWidget, JobPtr, LayoutTransform, ComponentTransform, WidgetProperties]()
+		{
+			GenerateRendererData(NiagaraWidget, *JobPtr, LayoutTransform, ComponentTransform, &WidgetProperties);
+		}, TStatId(), nullptr, ENamedThreads::AnyThread));
+	}
+	AsyncGenerationPending = true;
+}
+
+void UNiagaraUIComponent::ReleaseAsyncWidget(SNiagaraUISystemWidget* NiagaraWidget)
+{
+	if (!NiagaraWidget || AsyncWidget != NiagaraWidget)
 		return;
 
+	WaitForAsyncGeneration();
+	ReleaseRendererJobs();
+	AsyncGenerationPending = false;
+	AsyncWidget = nullptr;
+}
+
+FNiagaraUIBudgetUsage UNiagaraUIComponent::ConsumeBudgetUsage()
+{
+	FNiagaraUIBudgetUsage Usage = BudgetUsage;
+	Usage.GenerateCycles = (uint32)BudgetGenerateCycles.Set(0);
+
+	BudgetParticleDemand = Usage.Particles;
+	BudgetUsage.VisibleArea = 0.f;
+	BudgetUsage.Particles = 0;
+	return Usage;
+}
+
+void UNiagaraUIComponent::SetParticleBudget(int32 ParticleBudget)
+{
+	const float BudgetRatio = BudgetParticleDemand > 0 ? (float)ParticleBudget / BudgetParticleDemand : 1.f;
+	BudgetRenderFraction = FMath::Min(BudgetRatio, 1.f);
+
+	// The demand already follows the spawn scale, so the scale converges where the demand meets the budget
+	const float NewSpawnScale = FMath::Clamp(BudgetSpawnScale * FMath::Clamp(BudgetRatio, MinBudgetSpawnScaleStep, MaxBudgetSpawnScaleStep), MinBudgetSpawnScale, 1.f);
+	if (NewSpawnScale != BudgetSpawnScale)
+	{
+		BudgetSpawnScale = NewSpawnScale;
+
+		// Setting a parameter the system doesn't expose would add it to the overrides of every budgeted component
+		const FNiagaraVariable UserParameter(FNiagaraTypeDefinition::GetFloatDef(), BudgetSpawnScaleUserParameterName);
+		if (GetAsset() && GetAsset()->GetExposedParameters().FindParameterOffset(UserParameter))
+		{
+			SetVariableFloat(BudgetSpawnScaleParameterName, BudgetSpawnScale);
+		}
+	}
+}
+
+void UNiagaraUIComponent::WaitForAsyncGeneration()
+{
+	if (AsyncGenerateTasks.Num() > 0)
+	{
+		FTaskGraphInterface::Get().WaitUntilTasksComplete(AsyncGenerateTasks);
+		AsyncGenerateTasks.Reset();
+	}
+}
+
+// Emitter bounds are kept in the local space of the system, so they are projected the same way as local space particles.
+// Returns false when the bounds aren't known yet
+static bool GetEmitterBounds2D(const FNiagaraEmitterInstance& EmitterInst, const FSlateLayoutTransform& SlateLayoutTransform, const FTransform& ComponentTransform, FSlateRect& OutBounds)
+{
+	const FBox Bounds = const_cast<FNiagaraEmitterInstance&>(EmitterInst).GetBounds();
+	if (!Bounds.IsValid)
+		return false;
+
+	const FQuat ComponentRot = ComponentTransform.GetRotation();
+	const float LayoutScale = SlateLayoutTransform.GetScale();
+	const FVector WidgetAbsolutePosition = ComponentTransform.GetLocation() * LayoutScale;
+
+	FVector2D Min(MAX_flt, MAX_flt);
+	FVector2D Max(-MAX_flt, -MAX_flt);
+	for (int32 Corner = 0; Corner < 8; ++Corner)
+	{
+		const FVector Corner3D((Corner & 1) ? Bounds.Max.X : Bounds.Min.X, (Corner & 2) ? Bounds.Max.Y : Bounds.Min.Y, (Corner & 4) ? Bounds.Max.Z : Bounds.Min.Z);
+		const FVector WidgetRelative = ComponentRot.RotateVector(Corner3D) * LayoutScale;
+		const FVector2D Corner2D(WidgetAbsolutePosition.X + WidgetRelative.X, -WidgetAbsolutePosition.Z - WidgetRelative.Z);
+		Min = FVector2D::Min(Min, Corner2D);
+		Max = FVector2D::Max(Max, Corner2D);
+	}
+
+	OutBounds = FSlateRect(Min, Max);
+	return true;
+}
+
+bool UNiagaraUIComponent::ReserveRendererJobs(SNiagaraUISystemWidget* NiagaraWidget, bool HoldReadRefs, const FSlateLayoutTransform& SlateLayoutTransform, const FTransform& ComponentTransform, const FSlateRect& CullingRect)
+{
+	if (!IsActive())
+		return false;
+
 	if (!GetSystemInstance())
+		return false;
+
+	if (!IsRendererCacheValid())
+	{
+		BuildRendererCache();
+		PresizeRenderDataPending = true;
+	}
+
+	NiagaraWidget->BeginRenderDataUpdate();
+
+	if (PresizeRenderDataPending)
+	{
+		PresizeRenderData(NiagaraWidget);
+		PresizeRenderDataPending = false;
+	}
+
+	RendererJobs.Reset();
+	for (const FNiagaraUIRendererEntry& Renderer : CachedRenderers)
+	{
+		// Enable state is checked every frame, so toggling renderers or emitters doesn't need to rebuild the cache
+		if (!Renderer.RendererProperties->GetIsEnabled() || Renderer.EmitterInstance->IsDisabled())
+			continue;
+
+		// Emitters whose whole bounds are clipped away get no job, their particle data isn't touched at all
+		FSlateRect EmitterBounds;
+		if (GetEmitterBounds2D(Renderer.EmitterInstance.Get(), SlateLayoutTransform, ComponentTransform, EmitterBounds))
+		{
+			if (!FSlateRect::DoRectanglesIntersect(EmitterBounds, CullingRect))
+			{
+				INC_DWORD_STAT(STAT_NiagaraUICulledRenderers);
+				continue;
+			}
+			BudgetUsage.VisibleArea += EmitterBounds.IntersectionWith(CullingRect).GetArea();
+		}
+		else
+		{
+			BudgetUsage.VisibleArea += CullingRect.GetArea();
+		}
+
+		FNiagaraUIRendererJob& Job = RendererJobs.AddDefaulted_GetRef();
+		Job.CullingRect = CullingRect;
+		ReserveRendererJob(NiagaraWidget, Renderer, Job, HoldReadRefs, SlateLayoutTransform.GetScale());
+	}
+	return true;
+}
+
+void UNiagaraUIComponent::SubmitRendererJobs(SNiagaraUISystemWidget* NiagaraWidget)
+{
+	NiagaraWidget->BeginRenderDataSubmit();
+
+	// Submitting in the order of the jobs keeps the SortOrderHint draw order
+	for (const FNiagaraUIRendererJob& Job : RendererJobs)
+	{
+		for (int32 SlotIndex = 0; SlotIndex < Job.NumFilledRenderData; ++SlotIndex)
+		{
+			NiagaraWidget->SubmitRenderData(Job.RenderDataIndices[SlotIndex]);
+		}
+	}
+
+	NiagaraWidget->EndRenderDataUpdate();
+	ReleaseRendererJobs();
+}
+
+void UNiagaraUIComponent::ReleaseRendererJobs()
+{
+	for (FNiagaraUIRendererJob& Job : RendererJobs)
+	{
+		if (Job.HoldsReadRef)
+		{
+			Job.DataBuffer->ReleaseReadRef();
+			if (Job.PreviousDataBuffer)
+			{
+				Job.PreviousDataBuffer->ReleaseReadRef();
+			}
+			Job.HoldsReadRef = false;
+		}
+		Job.DataBuffer = nullptr;
+		Job.PreviousDataBuffer = nullptr;
+	}
+	RendererJobs.Reset();
+}
+
+void FNiagaraUIGenerateTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Owner)
+	{
+		Owner->StartAsyncGeneration();
+	}
+}
+
+FString FNiagaraUIGenerateTickFunction::DiagnosticMessage()
+{
+	return Owner ? Owner->GetFullName() + TEXT("[GenerateUIGeometry]") : TEXT("FNiagaraUIGenerateTickFunction");
+}
+
+// Picks the baked LOD of the renderer's mesh the same way static meshes pick their LOD, from the screen size of the mesh
+// drawn at ParticleScreenScale, the particle scale times the layout scale. A ParticleScreenScale of 0 always picks LOD 0
+static const FSlateMeshData* FindSlateMeshData(const SNiagaraUISystemWidget* NiagaraWidget, UNiagaraMeshRendererProperties* MeshRenderer, float ParticleScreenScale)
+{
+    const UNiagaraSystemWidget* Widget = NiagaraWidget->GetOwnerWidget();
+    if (!Widget || !MeshRenderer->ParticleMesh)
+        return nullptr;
+
+    const TArray<FSlateMeshDataPtr>* MeshLODs = Widget->FindMeshData(MeshRenderer->ParticleMesh->GetPackage()->GetFName());
+    if (!MeshLODs)
+        return nullptr;
+
+    const float ReferenceHeight = FMath::Max(CVarNiagaraUIMeshLODReferenceHeight.GetValueOnGameThread(), 1.f);
+    const FSlateMeshData* FoundMeshData = (*MeshLODs)[0].Get();
+    const float ScreenSize = ParticleScreenScale > 0.f ? FoundMeshData->Radius * 2.f * ParticleScreenScale / ReferenceHeight : MAX_flt;
+
+    // LODs are in order, every smaller LOD whose screen size the mesh still doesn't reach replaces the previous one
+    for (int32 LODIndex = 1; LODIndex < MeshLODs->Num() && (*MeshLODs)[LODIndex]->ScreenSize > ScreenSize; ++LODIndex)
+    {
+        FoundMeshData = (*MeshLODs)[LODIndex].Get();
+    }
+    return FoundMeshData;
+}
+
+// All ribbons of a renderer share one vertex and index buffer, a new chunk is started only when the vertices
+// wouldn't be addressable by SlateIndex anymore
+static const int32 MaxRibbonChunkVertices = (int32)FMath::Min<int64>(TNumericLimits<SlateIndex>::Max(), MAX_int32);
+
+void UNiagaraUIComponent::ReserveRendererJob(SNiagaraUISystemWidget* NiagaraWidget, const FNiagaraUIRendererEntry& Renderer, FNiagaraUIRendererJob& Job, bool HoldReadRef, float LayoutScale)
+{
+	Job.Renderer = &Renderer;
+
+	const FNiagaraDataSet& DataSet = Renderer.EmitterInstance->GetData();
+	if (!DataSet.IsCurrentDataValid())
+		return;
+
+	Job.DataBuffer = DataSet.GetCurrentData();
+	if (HoldReadRef)
+	{
+		Job.DataBuffer->AddReadRef();
+		Job.HoldsReadRef = true;
+	}
+	const int32 ParticleCount = Job.DataBuffer->GetNumInstances();
+
+	if (SimulationInterval > 0.f && PreviousParticleData.IsValidIndex(Renderer.EmitterIndex))
+	{
+		const FNiagaraUIPreviousParticleData& Previous = PreviousParticleData[Renderer.EmitterIndex];
+		if (Previous.DataBuffer && Previous.EmitterInstance.Get() == &Renderer.EmitterInstance.Get())
+		{
+			Job.PreviousDataBuffer = Previous.DataBuffer;
+			Job.InterpolationAlpha = FMath::Clamp((float)((GetClockSeconds() - LastSimulationTime) / SimulationInterval), 0.f, 1.f);
+			if (HoldReadRef)
+			{
+				Job.PreviousDataBuffer->AddReadRef();
+			}
+		}
+	}
+
+	BudgetUsage.Particles += ParticleCount;
+	if (BudgetRenderFraction < 1.f)
+	{
+		Job.MaxParticles = FMath::CeilToInt(ParticleCount * BudgetRenderFraction);
+	}
+
+	const FNiagaraUIRenderDataKey Key(&Renderer.EmitterInstance.Get(), Renderer.RendererProperties);
+
+	switch (Renderer.Type)
+	{
+	case ENiagaraUIRendererType::Sprite:
+		Job.RenderDataIndices.Add(NiagaraWidget->ReserveRenderData(Key, static_cast<UNiagaraSpriteRendererProperties*>(Renderer.RendererProperties)->Material, true));
+		break;
+	case ENiagaraUIRendererType::Ribbon:
+		{
+			// The greedy chunking needs at most one chunk per half of MaxRibbonChunkVertices, plus the last one
+			const int32 NumChunks = 1 + (int32)((int64)ParticleCount * 4 / MaxRibbonChunkVertices);
+			UMaterialInterface* Material = static_cast<UNiagaraRibbonRendererProperties*>(Renderer.RendererProperties)->Material;
+			for (int32 ChunkIndex = 0; ChunkIndex < NumChunks; ++ChunkIndex)
+			{
+				Job.RenderDataIndices.Add(NiagaraWidget->ReserveRenderData(FNiagaraUIRenderDataKey(Key.Emitter, Key.Renderer, ChunkIndex), Material, false));
+			}
+		}
+		break;
+	case ENiagaraUIRendererType::Mesh:
+		{
+			UNiagaraMeshRendererProperties* MeshRenderer = static_cast<UNiagaraMeshRendererProperties*>(Renderer.RendererProperties);
+
+			// The LOD follows the largest particle on screen, mesh particles are drawn with the X and Z of their scale
+			const FNiagaraUIFloatStream<3> ScaleData(DataSet, *Job.DataBuffer, MeshRenderer->ScaleBinding.GetDataSetBindableVariable().GetName());
+			float MaxParticleScale = 0.f;
+			for (int32 ParticleIndex = 0; ParticleIndex < ParticleCount; ++ParticleIndex)
+			{
+				MaxParticleScale = FMath::Max3(MaxParticleScale, FMath::Abs(ScaleData.Get(ParticleIndex, 0)), FMath::Abs(ScaleData.Get(ParticleIndex, 2)));
+			}
+
+			Job.MeshData = FindSlateMeshData(NiagaraWidget, MeshRenderer, MaxParticleScale * LayoutScale);
+			if (Job.MeshData)
+			{
+				Job.RenderDataIndices.Add(NiagaraWidget->ReserveRenderData(Key, MeshRenderer->OverrideMaterials[0].ExplicitMat, true));
+			}
+		}
+		break;
+	}
+}
+
+void UNiagaraUIComponent::GenerateRendererData(SNiagaraUISystemWidget* NiagaraWidget, FNiagaraUIRendererJob& Job, const FSlateLayoutTransform& SlateLayoutTransform, const FTransform& ComponentTransform, const FNiagaraWidgetProperties* WidgetProperties)
+{
+	if (Job.RenderDataIndices.Num() == 0)
 		return;
 
-    NiagaraWidget->ClearRenderData();
-	NiagaraWidget->ClearRuns(1);
-	TArray<FNiagaraRendererEntry> Renderers;
+	const FNiagaraUIRendererEntry& Renderer = *Job.Renderer;
+	const uint32 StartCycles = FPlatformTime::Cycles();
+
+	switch (Renderer.Type)
+	{
+	case ENiagaraUIRendererType::Sprite:
+		AddSpriteRendererData(NiagaraWidget, Job, Renderer.EmitterInstance, static_cast<UNiagaraSpriteRendererProperties*>(Renderer.RendererProperties), SlateLayoutTransform, ComponentTransform, WidgetProperties);
+		break;
+	case ENiagaraUIRendererType::Ribbon:
+		AddRibbonRendererData(NiagaraWidget, Job, Renderer.EmitterInstance, static_cast<UNiagaraRibbonRendererProperties*>(Renderer.RendererProperties), SlateLayoutTransform, ComponentTransform, WidgetProperties);
+		break;
+	case ENiagaraUIRendererType::Mesh:
+		AddMeshRendererData(NiagaraWidget, Job, Renderer.EmitterInstance, static_cast<UNiagaraMeshRendererProperties*>(Renderer.RendererProperties), SlateLayoutTransform, ComponentTransform, WidgetProperties);
+		break;
+	}
+
+	BudgetGenerateCycles.Add((int32)(FPlatformTime::Cycles() - StartCycles));
+}
 
-	for(TSharedRef<const FNiagaraEmitterInstance, ESPMode::ThreadSafe> EmitterInst : GetSystemInstance()->GetEmitters())
+void UNiagaraUIComponent::PresizeRenderData(SNiagaraUISystemWidget* NiagaraWidget)
+{
+	for (const FNiagaraUIRendererEntry& Renderer : CachedRenderers)
 	{
-		if (UNiagaraEmitter* Emitter = EmitterInst->GetCachedEmitter())
-		{
-			TArray<UNiagaraRendererProperties*> Properties = Emitter->GetRenderers();
+		const int32 MaxParticleCount = Renderer.EmitterInstance->GetCachedEmitter()->GetMaxParticleCountEstimate();
+		if (MaxParticleCount < 1)
+			continue;
 
-			for (UNiagaraRendererProperties* Property : Properties)
-			{
-				FNiagaraRendererEntry NewEntry(Property, EmitterInst, Emitter);
-                Renderers.Add(NewEntry);
-			}
-		}
-	}
+		const FNiagaraUIRenderDataKey Key(&Renderer.EmitterInstance.Get(), Renderer.RendererProperties);
 
-	Algo::Sort(Renderers, [] (FNiagaraRendererEntry& FirstElement, FNiagaraRendererEntry& SecondElement) {return FirstElement.RendererProperties->SortOrderHint < SecondElement.RendererProperties->SortOrderHint;});
-    
-	for (FNiagaraRendererEntry Renderer : Renderers)
-	{
-		if (Renderer.RendererProperties && Renderer.RendererProperties->GetIsEnabled() && Renderer.RendererProperties->IsSimTargetSupported(Renderer.Emitter->SimTarget))
+		switch (Renderer.Type)
 		{
-			if (Renderer.Emitter->SimTarget == ENiagaraSimTarget::CPUSim)
+		case ENiagaraUIRendererType::Sprite:
+			NiagaraWidget->PresizeRenderData(Key, 4, 6, MaxParticleCount);
+			break;
+		case ENiagaraUIRendererType::Ribbon:
+			NiagaraWidget->PresizeRenderData(Key, MaxParticleCount * 2, MaxParticleCount * 6, 1);
+			break;
+		case ENiagaraUIRendererType::Mesh:
+			if (const FSlateMeshData* MeshData = FindSlateMeshData(NiagaraWidget, static_cast<UNiagaraMeshRendererProperties*>(Renderer.RendererProperties), 0.f))
 			{
-				if (UNiagaraSpriteRendererProperties* SpriteRenderer = Cast<UNiagaraSpriteRendererProperties>(Renderer.RendererProperties))
-				{
-					AddSpriteRendererData(NiagaraWidget, Renderer.EmitterInstance, SpriteRenderer, SlateLayoutTransform, ComponentTransform, WidgetProperties);
-				}
-				else if (UNiagaraRibbonRendererProperties* RibbonRenderer = Cast<UNiagaraRibbonRendererProperties>(Renderer.RendererProperties))
-				{
-					AddRibbonRendererData(NiagaraWidget, Renderer.EmitterInstance, RibbonRenderer, SlateLayoutTransform, ComponentTransform, WidgetProperties);
-				}
-                else if (UNiagaraMeshRendererProperties* MeshRenderer = Cast<UNiagaraMeshRendererProperties>(Renderer.RendererProperties))
-                {
-                    AddMeshRendererData(NiagaraWidget, Renderer.EmitterInstance, MeshRenderer, SlateLayoutTransform, ComponentTransform, WidgetProperties);
-                }
+				NiagaraWidget->PresizeRenderData(Key, MeshData->Vertex.Num(), MeshData->Index.Num(), MaxParticleCount);
 			}
+			break;
 		}
 	}
 }
@@ -94,274 +802,452 @@ FORCEINLINE FVector2D FastRotate(const FVector2D Vector, float Sin, float Cos)
                      Sin * Vector.X + Cos * Vector.Y);
 }
 
-template<int32 Component, int32 ByteIndex>
-static void PackUint8IntoByte(FVector4& Data, uint8 InValue)
+// Identifies the sprite quad as resident geometry of the render data slots
+static const int32 SpriteQuadGeometry = 0;
+
+// Sprite quads span 10 units around the particle at scale 1, rotated they reach sqrt(2) further
+static const float SpriteCullRadiusPerScale = 10.f * UE_SQRT_2;
+
+FORCEINLINE static bool IsOutsideCullingRect(const FSlateRect& CullingRect, const FVector2D& Position, float Radius)
 {
-    static const uint32 Mask = ~(0xFF << ByteIndex * 8);
-    uint32* CurrentData = (uint32*)(&Data[Component]);
-    *CurrentData = (*CurrentData) & Mask;
-    *CurrentData = (*CurrentData) | (InValue << ByteIndex * 8);
+    return Position.X + Radius < CullingRect.Left || Position.X - Radius > CullingRect.Right
+        || Position.Y + Radius < CullingRect.Top || Position.Y - Radius > CullingRect.Bottom;
 }
 
-template<int32 Component, int32 ByteIndex>
-static void PackUint16IntoByte(FVector4& Data, uint16 InValue)
+// Particles per parallel chunk, sized so a chunk's instances and attribute reads stay in cache
+static const int32 ParallelInstanceChunkSize = 1024;
+
+static int32 FlushPackBatch(FNiagaraUIPackBatch& Batch, ENiagaraUIInstanceFormat Format, uint8 SubImageGrid, FVector4* OutInstances, bool UseSIMD)
 {
-    static const uint32 Mask = ~(0xFFFF << ByteIndex * 16);
-    uint32* CurrentData = (uint32*)(&Data[Component]);
-    *CurrentData = (*CurrentData) & Mask;
-    *CurrentData = (*CurrentData) | (InValue << ByteIndex * 16);
+    const int32 NumPacked = Batch.Num;
+    if (Format == ENiagaraUIInstanceFormat::Wide)
+    {
+        NiagaraUIPackInstancesWide(Batch, OutInstances);
+    }
+    else if (UseSIMD)
+    {
+        NiagaraUIPackInstances(Batch, SubImageGrid, OutInstances);
+    }
+    else
+    {
+        NiagaraUIPackInstancesScalar(Batch, 0, SubImageGrid, OutInstances);
+    }
+    Batch.Num = 0;
+    return NumPacked;
 }
 
-static void InitPack(FVector4& Datas)
+// Sorts the particles by the renderer's sort mode. View depth is the Y axis also used by FakeDepthScale, the particles
+// farthest away are drawn first. Returns null when the particles keep the order of the data buffer
+static const int32* SortParticles(FNiagaraUIParticleSortBuffers& SortBuffers, ENiagaraSortMode SortMode, const FNiagaraUIFloatStream<3>& PositionData, const FNiagaraUIFloatStream<1>& CustomSortingData, int32 ParticleCount)
 {
-    PackUint8IntoByte<0, 3>(Datas, 2);
-    PackUint8IntoByte<1, 3>(Datas, 2);
-    PackUint8IntoByte<2, 3>(Datas, 2);
-    PackUint8IntoByte<3, 3>(Datas, 2);
+    if (SortMode == ENiagaraSortMode::None || ParticleCount < 2)
+        return nullptr;
 
-}
+    SCOPE_CYCLE_COUNTER(STAT_NiagaraUISortParticles);
 
-static void PackColor(FVector4& Datas,FColor Color)
-{
-    PackUint8IntoByte<2, 0>(Datas, Color.R);
-    PackUint8IntoByte<2, 1>(Datas, Color.G);
-    PackUint8IntoByte<2, 2>(Datas, Color.B);
-    PackUint8IntoByte<2, 3>(Datas, ((Color.A >> 2) << 2) + 2);
-}
+    const bool ViewSort = SortMode == ENiagaraSortMode::ViewDepth || SortMode == ENiagaraSortMode::ViewDistance;
 
-static void PackPosition(FVector4& Datas, FVector2D Pos)
-{
-	Pos = Pos.ClampAxes(-1000.f,15383.f);
+    // Descending orders flip the keys, so the ascending radix sort stays stable for equal values
+    const uint32 KeyFlip = (ViewSort || SortMode == ENiagaraSortMode::CustomDecending) ? 0xFFFFFFFFu : 0u;
+
+    SortBuffers.Keys.SetNumUninitialized(ParticleCount, false);
+    uint32* Keys = SortBuffers.Keys.GetData();
+    if (ViewSort)
+    {
+        for (int32 ParticleIndex = 0; ParticleIndex < ParticleCount; ++ParticleIndex)
+        {
+            Keys[ParticleIndex] = NiagaraUISortKey(PositionData.Get(ParticleIndex, 1)) ^ KeyFlip;
+        }
+    }
+    else
+    {
+        for (int32 ParticleIndex = 0; ParticleIndex < ParticleCount; ++ParticleIndex)
+        {
+            Keys[ParticleIndex] = NiagaraUISortKey(CustomSortingData.Get(ParticleIndex)) ^ KeyFlip;
+        }
+    }
 
-    PackUint16IntoByte<0, 0>(Datas, uint16((Pos.X + 1000.f) * 4.0f));
-    PackUint16IntoByte<1, 0>(Datas, uint16((Pos.Y + 1000.f) * 4.0f));
+    NiagaraUIRadixSort(SortBuffers);
+    return SortBuffers.Indices.GetData();
 }
 
-static void PackScale(FVector4& Datas, FVector2D Scale)
+// Drops the particles over the job's budget from the draw order. Sorted particles keep the ones drawn last, which end
+// up in front
+static const int32* TruncateToBudget(const FNiagaraUIRendererJob& Job, const int32* ParticleOrder, int32& InOutParticleCount)
 {
-	Scale = Scale.ClampAxes(0.f,127.f);
+    if (InOutParticleCount <= Job.MaxParticles)
+        return ParticleOrder;
 
-	uint16 SizeX = uint16(Scale.X * 128.0f);
-    PackUint8IntoByte<0, 2>(Datas, (SizeX & 0xFF00) >> 8);
-    PackUint8IntoByte<0, 3>(Datas, (((SizeX & 0x00FF) >> 2) << 2) + 2);
+    const int32 NumTruncated = InOutParticleCount - Job.MaxParticles;
+    INC_DWORD_STAT_BY(STAT_NiagaraUIBudgetTruncatedParticles, NumTruncated);
 
-    uint16 SizeY = uint16(Scale.Y * 128.0f);
-    PackUint8IntoByte<1, 2>(Datas, (SizeY & 0xFF00) >> 8);
-    PackUint8IntoByte<1, 3>(Datas, (((SizeY & 0x00FF) >> 2) << 2) + 2);
+    InOutParticleCount = Job.MaxParticles;
+    return ParticleOrder ? ParticleOrder + NumTruncated : nullptr;
 }
 
-static void PackRotation(FVector4& Datas, float rot)
+// Packs the instances of all particles accepted by GatherParticle, which adds the particle to the batch or skips it when culled.
+// ParticleOrder lists the particle indices in draw order, null keeps the order of the data buffer.
+// Returns the number of culled particles.
+// Large emitters are split into chunks packed in parallel into their own slice of the buffer and compacted afterwards,
+// so the instance order is the same as with the serial loop.
+template<typename GatherFunc>
+static int32 GenerateInstances(FSlateInstanceBufferData& InstanceData, int32 ParticleCount, const int32* ParticleOrder, ENiagaraUIInstanceFormat Format, uint8 SubImageGrid, const GatherFunc& GatherParticle)
 {
-	float Angle = FMath::Fmod(rot, 360.f);
-    if (Angle < 0.f) Angle += 360.f;
-    uint16 urot = uint16(Angle * 32.0f);
-    PackUint8IntoByte<3, 2>(Datas, (urot & 0xFF00) >> 8);
-    PackUint8IntoByte<3, 3>(Datas, (((urot & 0x00FF) >> 2) << 2) + 2);
-}
+    const bool UseSIMD = CVarNiagaraUISIMDPacking.GetValueOnAnyThread() != 0;
+    const int32 ParallelThreshold = CVarNiagaraUIParallelInstanceThreshold.GetValueOnAnyThread();
 
-static void PackSubImage(FVector4& Datas, uint8 index,uint8 sizeX,uint8 sizeY)
-{
-    PackUint8IntoByte<3, 0>(Datas, index);
-    PackUint8IntoByte<3, 1>(Datas, sizeY * 16 + sizeX);
-}
+    InstanceData.SetNumUninitialized(ParticleCount, false);
+    FVector4* Instances = InstanceData.GetData();
 
-void UNiagaraUIComponent::AddSpriteRendererData(SNiagaraUISystemWidget* NiagaraWidget, TSharedRef<const FNiagaraEmitterInstance, ESPMode::ThreadSafe> EmitterInst, UNiagaraSpriteRendererProperties* SpriteRenderer, const FSlateLayoutTransform& SlateLayoutTransform, const FTransform& ComponentTransform, const FNiagaraWidgetProperties* WidgetProperties)
-{
+    if (ParallelThreshold <= 0 || ParticleCount < ParallelThreshold)
     {
-        SCOPE_CYCLE_COUNTER(STAT_GenerateSpriteData);
-
-        FNiagaraDataSet& DataSet = EmitterInst->GetData();
-        if (!DataSet.IsCurrentDataValid())
+        FNiagaraUIPackBatch PackBatch;
+        int32 NumInstances = 0;
+        for (int32 OrderIndex = 0; OrderIndex < ParticleCount; ++OrderIndex)
         {
-            return;
+            GatherParticle(ParticleOrder ? ParticleOrder[OrderIndex] : OrderIndex, PackBatch);
+            if (PackBatch.IsFull())
+            {
+                NumInstances += FlushPackBatch(PackBatch, Format, SubImageGrid, Instances + NumInstances, UseSIMD);
+            }
         }
-        FNiagaraDataBuffer& ParticleData = DataSet.GetCurrentDataChecked();
-        const int32 ParticleCount = ParticleData.GetNumInstances();
+        NumInstances += FlushPackBatch(PackBatch, Format, SubImageGrid, Instances + NumInstances, UseSIMD);
+        InstanceData.SetNum(NumInstances, false);
+        return ParticleCount - NumInstances;
+    }
 
-        if (ParticleCount < 1)
-            return;
+    const int32 NumChunks = FMath::DivideAndRoundUp(ParticleCount, ParallelInstanceChunkSize);
+    TArray<int32, TInlineAllocator<64>> ChunkInstanceCounts;
+    ChunkInstanceCounts.SetNumZeroed(NumChunks);
 
-		//Add a box mesh
-		
-        FSlateVertex* VertexData;
-        SlateIndex* IndexData;
+    ParallelFor(NumChunks, [&](int32 ChunkIndex)
+    {
+        const int32 FirstParticle = ChunkIndex * ParallelInstanceChunkSize;
+        const int32 EndParticle = FMath::Min(FirstParticle + ParallelInstanceChunkSize, ParticleCount);
+        FVector4* ChunkInstances = Instances + FirstParticle;
 
-        FSlateBrush Brush;
-
-        UMaterialInterface* SpriteMaterial = SpriteRenderer->Material;
-        uint32 RenderDataIndex = NiagaraWidget->AddRenderDataWithInstance(&VertexData, &IndexData, SpriteMaterial, 4, 6);
-
-        VertexData[0].Position = FVector2D(-10, -10);
-        VertexData[0].Color = FColor(255, 0, 0, 255);
-        VertexData[0].TexCoords[0] = 0;
-        VertexData[0].TexCoords[1] = 0;
-        VertexData[0].TexCoords[2] = 0;
-        VertexData[0].TexCoords[3] = 0;
-
-        VertexData[1].Position = FVector2D(10, -10);
-        VertexData[1].Color = FColor(255, 0, 0, 255);
-        VertexData[1].TexCoords[0] = 1;
-        VertexData[1].TexCoords[1] = 0;
-        VertexData[1].TexCoords[2] = 0;
-        VertexData[1].TexCoords[3] = 0;
-
-        VertexData[2].Position = FVector2D(10, 10);
-        VertexData[2].Color = FColor(255, 0, 0, 255);
-        VertexData[2].TexCoords[0] = 1;
-        VertexData[2].TexCoords[1] = 1;
-        VertexData[2].TexCoords[2] = 0;
-        VertexData[2].TexCoords[3] = 0;
-
-        VertexData[3].Position = FVector2D(-10, 10);
-        VertexData[3].Color = FColor(255, 0, 0, 255);
-        VertexData[3].TexCoords[0] = 0;
-        VertexData[3].TexCoords[1] = 1;
-        VertexData[3].TexCoords[2] = 0;
-        VertexData[3].TexCoords[3] = 0;
-
-        IndexData[0] = 0;
-        IndexData[1] = 1;
-        IndexData[2] = 2;
-
-        IndexData[3] = 0;
-        IndexData[4] = 2;
-        IndexData[5] = 3;
-		
-		
-        const auto PositionData = FNiagaraDataSetAccessor<FVector>::CreateReader(DataSet, SpriteRenderer->PositionBinding.GetDataSetBindableVariable().GetName());
-        const auto ColorData = FNiagaraDataSetAccessor<FLinearColor>::CreateReader(DataSet, SpriteRenderer->ColorBinding.GetDataSetBindableVariable().GetName());
-        const auto VelocityData = FNiagaraDataSetAccessor<FVector>::CreateReader(DataSet, SpriteRenderer->VelocityBinding.GetDataSetBindableVariable().GetName());
-        const auto SizeData = FNiagaraDataSetAccessor<FVector2D>::CreateReader(DataSet, SpriteRenderer->SpriteSizeBinding.GetDataSetBindableVariable().GetName());
-        const auto RotationData = FNiagaraDataSetAccessor<float>::CreateReader(DataSet, SpriteRenderer->SpriteRotationBinding.GetDataSetBindableVariable().GetName());
-        const auto SubImageData = FNiagaraDataSetAccessor<float>::CreateReader(DataSet, SpriteRenderer->SubImageIndexBinding.GetDataSetBindableVariable().GetName());
-        const auto DynamicMaterialData = FNiagaraDataSetAccessor<FVector4>::CreateReader(DataSet, SpriteRenderer->DynamicMaterialBinding.GetDataSetBindableVariable().GetName());
-
-        bool LocalSpace = EmitterInst->GetCachedEmitter()->bLocalSpace;
-        const float FakeDepthScaler = 1 / WidgetProperties->FakeDepthScaleDistance;
-        FVector2D SubImageSize = SpriteRenderer->SubImageSize;
-
-		FVector ComponentPos = ComponentTransform.GetLocation();
-        FQuat ComponentRot = ComponentTransform.GetRotation();
-        float ComponentRotAng =FMath::RadiansToDegrees(ComponentRot.GetAngle());
-        float LayoutScale = SlateLayoutTransform.GetScale();
-        FVector WidgetAbsolutePosition = ComponentPos*LayoutScale;
-
-        auto GetParticlePosition2D = [&LocalSpace , &LayoutScale,&WidgetAbsolutePosition,&ComponentPos,&ComponentRot ,&PositionData](int32 Index)
+        FNiagaraUIPackBatch PackBatch;
+        int32 NumInstances = 0;
+        for (int32 OrderIndex = FirstParticle; OrderIndex < EndParticle; ++OrderIndex)
         {
-            const FVector Position3D = PositionData.GetSafe(Index, FVector::ZeroVector);
-			FVector ComponentRelative = LocalSpace ? ComponentRot.RotateVector(Position3D) : Position3D - ComponentPos;
-			FVector WidgetRelative = ComponentRelative * LayoutScale;
-            return  FVector2D(WidgetAbsolutePosition.X + WidgetRelative.X,-WidgetAbsolutePosition.Z - WidgetRelative.Z);
-        };
+            GatherParticle(ParticleOrder ? ParticleOrder[OrderIndex] : OrderIndex, PackBatch);
+            if (PackBatch.IsFull())
+            {
+                NumInstances += FlushPackBatch(PackBatch, Format, SubImageGrid, ChunkInstances + NumInstances, UseSIMD);
+            }
+        }
+        NumInstances += FlushPackBatch(PackBatch, Format, SubImageGrid, ChunkInstances + NumInstances, UseSIMD);
+        ChunkInstanceCounts[ChunkIndex] = NumInstances;
+    });
 
-        auto GetParticleDepth = [&PositionData](int32 Index)
+    // Close the gaps left by culled particles, chunk by chunk in particle order
+    int32 NumInstances = ChunkInstanceCounts[0];
+    for (int32 ChunkIndex = 1; ChunkIndex < NumChunks; ++ChunkIndex)
+    {
+        const int32 ChunkCount = ChunkInstanceCounts[ChunkIndex];
+        const int32 ChunkStart = ChunkIndex * ParallelInstanceChunkSize;
+        if (ChunkCount > 0 && ChunkStart != NumInstances)
         {
-            return PositionData.GetSafe(Index, FVector::ZeroVector).Y;
-        };
+            FMemory::Memmove(Instances + NumInstances, Instances + ChunkStart, ChunkCount * sizeof(FVector4));
+        }
+        NumInstances += ChunkCount;
+    }
+    InstanceData.SetNum(NumInstances, false);
+    return ParticleCount - NumInstances;
+}
 
-        auto GetParticleColor = [&ColorData](int32 Index)
-        {
-            return ColorData.GetSafe(Index, FLinearColor::White);
-        };
+// Screen position of a particle. Local space particles are rotated with the component, world space ones are relative to it
+template<bool LocalSpace>
+FORCEINLINE static FVector2D GetParticleWidgetPosition(const FVector& Position3D, const FVector& ComponentPos, const FQuat& ComponentRot, float LayoutScale)
+{
+    const FVector ComponentRelative = LocalSpace ? ComponentRot.RotateVector(Position3D) : Position3D - ComponentPos;
+    const FVector WidgetPosition = (ComponentPos + ComponentRelative) * LayoutScale;
+    return FVector2D(WidgetPosition.X, -WidgetPosition.Z);
+}
 
-        auto GetParticleVelocity2D = [&LocalSpace ,&ComponentRot ,&VelocityData](int32 Index)
-        {
-            const FVector Velocity3D = VelocityData.GetSafe(Index, FVector::ZeroVector);
-            FVector RelativeVelocity3D = LocalSpace ? ComponentRot.RotateVector(Velocity3D): Velocity3D;
-            return FVector2D(RelativeVelocity3D.X, RelativeVelocity3D.Z);
-        };
+// Renderer and widget settings the sprite loop is specialized on, combined into the index of SpriteKernels
+static const int32 SpriteKernelLocalSpace = 1 << 0;
+static const int32 SpriteKernelVelocityAligned = 1 << 1;
+static const int32 SpriteKernelFakeDepth = 1 << 2;
+static const int32 SpriteKernelSubImages = 1 << 3;
 
-        auto GetParticleSize = [&SizeData](int32 Index)
-        {
-            return SizeData.GetSafe(Index, FVector2D::ZeroVector);
-        };
+// Inputs of the sprite loop, fixed for the renderer's frame
+struct FNiagaraUISpriteKernelContext
+{
+    const FNiagaraUIRendererJob& Job;
+    const FNiagaraUIParticleInterpolation& Interpolation;
+    const FNiagaraUIFloatStream<3>& PositionData;
+    const FNiagaraUIFloatStream<3>& PreviousPositionData;
+    const FNiagaraUIFloatStream<4>& ColorData;
+    const FNiagaraUIFloatStream<4>& PreviousColorData;
+    const FNiagaraUIFloatStream<3>& VelocityData;
+    const FNiagaraUIFloatStream<2>& SizeData;
+    const FNiagaraUIFloatStream<1>& RotationData;
+    const FNiagaraUIFloatStream<1>& PreviousRotationData;
+    const FNiagaraUIFloatStream<1>& SubImageData;
+    FVector ComponentPos;
+    FQuat ComponentRot;
+    float LayoutScale;
+    float FakeDepthScaleDistance;
+    float CullAlphaThreshold;
+    float CullMinPixelSize;
+    uint8 SubImageGrid;
+};
 
-        auto GetParticleRotation = [&RotationData](int32 Index)
-        {
-            return RotationData.GetSafe(Index, 0.f);
-        };
+template<int32 Flags>
+struct TNiagaraUISpriteKernel
+{
+    static const bool LocalSpace = (Flags & SpriteKernelLocalSpace) != 0;
+    static const bool VelocityAligned = (Flags & SpriteKernelVelocityAligned) != 0;
+    static const bool FakeDepth = (Flags & SpriteKernelFakeDepth) != 0;
+    static const bool SubImages = (Flags & SpriteKernelSubImages) != 0;
 
-        auto GetParticleSubImage = [&SubImageData](int32 Index)
-        {
-            return SubImageData.GetSafe(Index, 0.f);
-        };
+    static int32 Generate(const FNiagaraUISpriteKernelContext& Context, FSlateInstanceBufferData& InstanceData, int32 ParticleCount, const int32* ParticleOrder)
+    {
+        const float FakeDepthScaler = 1.f / FMath::Max(Context.FakeDepthScaleDistance, KINDA_SMALL_NUMBER);
 
-        auto GetDynamicMaterialData = [&DynamicMaterialData](int32 Index)
+        auto GatherParticle = [&Context, FakeDepthScaler](int32 ParticleIndex, FNiagaraUIPackBatch& PackBatch)
         {
-            return DynamicMaterialData.GetSafe(Index, FVector4(0.f, 0.f, 0.f, 0.f));
-        };
+            const FVector Position3D = Context.Interpolation.GetVector(Context.PositionData, Context.PreviousPositionData, ParticleIndex);
+            const FVector2D ParticlePosition = GetParticleWidgetPosition<LocalSpace>(Position3D, Context.ComponentPos, Context.ComponentRot, Context.LayoutScale);
 
-        FSlateInstanceBufferData InstanceData;
+            FVector2D ParticleScale = Context.SizeData.GetVector2D(ParticleIndex) * 0.05f * Context.LayoutScale;
+            if (FakeDepth)
+            {
+                // Depth of the drawn position, so interpolated particles scale with the position they're drawn at. Particles at
+                // or beyond the fake camera distance shrink to nothing and are culled instead of being drawn mirrored
+                ParticleScale *= FMath::Max((Context.FakeDepthScaleDistance - Position3D.Y) * FakeDepthScaler, 0.f);
+            }
 
-        for (int ParticleIndex = 0; ParticleIndex < ParticleCount; ++ParticleIndex)
-        {
+            const float CullRadius = FMath::Max(FMath::Abs(ParticleScale.X), FMath::Abs(ParticleScale.Y)) * SpriteCullRadiusPerScale;
+            if (CullRadius * 2.f < Context.CullMinPixelSize || IsOutsideCullingRect(Context.Job.CullingRect, ParticlePosition, CullRadius))
+                return;
 
-            FVector2D ParticlePosition = GetParticlePosition2D(ParticleIndex);
-            FVector2D ParticleSize = GetParticleSize(ParticleIndex);
-            FVector2D ParticleScale = ParticleSize * 0.05 * SlateLayoutTransform.GetScale();
-			
-			FVector2D ParticleTestPos = ParticlePosition + ParticleSize * 15.f; // Max than sqrt(2)
-			if (ParticleTestPos.X < 0.f || ParticleTestPos.Y < 0.f) continue;
+            const FLinearColor ParticleColor = Context.Interpolation.GetColor(Context.ColorData, Context.PreviousColorData, ParticleIndex);
+            if (ParticleColor.A < Context.CullAlphaThreshold)
+                return;
 
-            if (WidgetProperties->FakeDepthScale)
+            float ParticleRotation;
+            if (VelocityAligned)
+            {
+                const FVector Velocity3D = Context.VelocityData.GetVector(ParticleIndex);
+                const FVector RelativeVelocity3D = LocalSpace ? Context.ComponentRot.RotateVector(Velocity3D) : Velocity3D;
+                ParticleRotation = FMath::RadiansToDegrees(FMath::Atan2(RelativeVelocity3D.X, RelativeVelocity3D.Z));
+            }
+            else
             {
-                const float ParticleDepth = (-GetParticleDepth(ParticleIndex) + WidgetProperties->FakeDepthScaleDistance) * FakeDepthScaler;
-                ParticleSize *= ParticleDepth;
+                ParticleRotation = Context.Interpolation.GetAngleDegrees(Context.RotationData, Context.PreviousRotationData, ParticleIndex);
             }
 
-            const FColor ParticleColor = GetParticleColor(ParticleIndex).ToFColor(false);
+            const float ParticleSubImage = SubImages ? Context.SubImageData.Get(ParticleIndex) : 0.f;
+
+            PackBatch.Add(ParticlePosition, ParticleScale, ParticleRotation, ParticleColor, ParticleSubImage);
+        };
+
+        return GenerateInstances(InstanceData, ParticleCount, ParticleOrder, Context.Job.Renderer->InstanceFormat, Context.SubImageGrid, GatherParticle);
+    }
+};
+
+typedef int32 (*FNiagaraUISpriteKernelFunc)(const FNiagaraUISpriteKernelContext&, FSlateInstanceBufferData&, int32, const int32*);
+
+static const FNiagaraUISpriteKernelFunc SpriteKernels[] =
+{
+    &TNiagaraUISpriteKernel<0>::Generate, &TNiagaraUISpriteKernel<1>::Generate, &TNiagaraUISpriteKernel<2>::Generate, &TNiagaraUISpriteKernel<3>::Generate,
+    &TNiagaraUISpriteKernel<4>::Generate, &TNiagaraUISpriteKernel<5>::Generate, &TNiagaraUISpriteKernel<6>::Generate, &TNiagaraUISpriteKernel<7>::Generate,
+    &TNiagaraUISpriteKernel<8>::Generate, &TNiagaraUISpriteKernel<9>::Generate, &TNiagaraUISpriteKernel<10>::Generate, &TNiagaraUISpriteKernel<11>::Generate,
+    &TNiagaraUISpriteKernel<12>::Generate, &TNiagaraUISpriteKernel<13>::Generate, &TNiagaraUISpriteKernel<14>::Generate, &TNiagaraUISpriteKernel<15>::Generate
+};
+
+// Renderer settings the mesh loop is specialized on, combined into the index of MeshKernels
+static const int32 MeshKernelLocalSpace = 1 << 0;
+static const int32 MeshKernelVelocityFacing = 1 << 1;
 
-			float ParticleRotation = 0.0;           
+// Inputs of the mesh loop, fixed for the renderer's frame
+struct FNiagaraUIMeshKernelContext
+{
+    const FNiagaraUIRendererJob& Job;
+    const FNiagaraUIParticleInterpolation& Interpolation;
+    const FNiagaraUIFloatStream<3>& PositionData;
+    const FNiagaraUIFloatStream<3>& PreviousPositionData;
+    const FNiagaraUIFloatStream<4>& ColorData;
+    const FNiagaraUIFloatStream<4>& PreviousColorData;
+    const FNiagaraUIFloatStream<3>& VelocityData;
+    const FNiagaraUIFloatStream<3>& SizeData;
+    const FNiagaraUIFloatStream<4>& RotationData;
+    const FNiagaraUIFloatStream<4>& PreviousRotationData;
+    FVector ComponentPos;
+    FQuat ComponentRot;
+    float LayoutScale;
+    float MeshRadius;
+    float CullAlphaThreshold;
+    float CullMinPixelSize;
+};
+
+template<int32 Flags>
+struct TNiagaraUIMeshKernel
+{
+    static const bool LocalSpace = (Flags & MeshKernelLocalSpace) != 0;
+    static const bool VelocityFacing = (Flags & MeshKernelVelocityFacing) != 0;
+
+    static int32 Generate(const FNiagaraUIMeshKernelContext& Context, FSlateInstanceBufferData& InstanceData, int32 ParticleCount, const int32* ParticleOrder)
+    {
+        auto GatherParticle = [&Context](int32 ParticleIndex, FNiagaraUIPackBatch& PackBatch)
+        {
+            const FVector Position3D = Context.Interpolation.GetVector(Context.PositionData, Context.PreviousPositionData, ParticleIndex);
+            const FVector2D ParticlePosition = GetParticleWidgetPosition<LocalSpace>(Position3D, Context.ComponentPos, Context.ComponentRot, Context.LayoutScale);
+            const FVector ParticleScale = Context.SizeData.GetVector(ParticleIndex) * Context.LayoutScale;
+
+            const float CullRadius = FMath::Max(FMath::Abs(ParticleScale.X), FMath::Abs(ParticleScale.Z)) * Context.MeshRadius;
+            if (CullRadius * 2.f < Context.CullMinPixelSize || IsOutsideCullingRect(Context.Job.CullingRect, ParticlePosition, CullRadius))
+                return;
 
-            if (SpriteRenderer->Alignment == ENiagaraSpriteAlignment::VelocityAligned)
+            const FLinearColor ParticleColor = Context.Interpolation.GetColor(Context.ColorData, Context.PreviousColorData, ParticleIndex);
+            if (ParticleColor.A < Context.CullAlphaThreshold)
+                return;
+
+            FVector FacingVector;
+            if (VelocityFacing)
             {
-                const FVector2D ParticleVelocity = GetParticleVelocity2D(ParticleIndex);
-                float Ang = FMath::Atan2(ParticleVelocity.X, ParticleVelocity.Y);
-				ParticleRotation = FMath::RadiansToDegrees(Ang);
+                const FVector Velocity3D = Context.VelocityData.GetVector(ParticleIndex);
+                FacingVector = LocalSpace ? Context.ComponentRot.RotateVector(Velocity3D) : Velocity3D;
             }
             else
             {
-				float Ang = GetParticleRotation(ParticleIndex);
-                ParticleRotation = Ang;
+                FacingVector = Context.Interpolation.GetQuat(Context.RotationData, Context.PreviousRotationData, ParticleIndex).RotateVector(FVector(1, 0, 0));
             }
-            
-            float ParticleSubImage = 0;
-            int Row = (int)SubImageSize.Y;
-            int Column = (int)SubImageSize.X;
+            const float ParticleAngle = FMath::RadiansToDegrees(FMath::Atan2(-FacingVector.Z, FacingVector.X));
 
-            if (SubImageSize != FVector2D(1.f, 1.f))
-            {
-                ParticleSubImage = GetParticleSubImage(ParticleIndex);
-            }
-			
-            FSlateVectorArtInstanceData ArtInstData;
-            FVector4& data = ArtInstData.GetData();
-            InitPack(data);
-            PackPosition(data, ParticlePosition);
-            PackRotation(data, ParticleRotation);
-            PackColor(data, ParticleColor);
-            PackScale(data, ParticleScale);
-            PackSubImage(data, ParticleSubImage, Column, Row);
-            InstanceData.Add(ArtInstData.GetData());
-            
+            // Meshes have no sub images, the index and grid bytes stay zero
+            PackBatch.Add(ParticlePosition, FVector2D(ParticleScale.X, ParticleScale.Z), ParticleAngle, ParticleColor, 0.f);
+        };
+
+        return GenerateInstances(InstanceData, ParticleCount, ParticleOrder, Context.Job.Renderer->InstanceFormat, 0, GatherParticle);
+    }
+};
+
+typedef int32 (*FNiagaraUIMeshKernelFunc)(const FNiagaraUIMeshKernelContext&, FSlateInstanceBufferData&, int32, const int32*);
+
+static const FNiagaraUIMeshKernelFunc MeshKernels[] =
+{
+    &TNiagaraUIMeshKernel<0>::Generate, &TNiagaraUIMeshKernel<1>::Generate, &TNiagaraUIMeshKernel<2>::Generate, &TNiagaraUIMeshKernel<3>::Generate
+};
+
+void UNiagaraUIComponent::AddSpriteRendererData(SNiagaraUISystemWidget* NiagaraWidget, FNiagaraUIRendererJob& Job, const TSharedRef<const FNiagaraEmitterInstance, ESPMode::ThreadSafe>& EmitterInst, UNiagaraSpriteRendererProperties* SpriteRenderer, const FSlateLayoutTransform& SlateLayoutTransform, const FTransform& ComponentTransform, const FNiagaraWidgetProperties* WidgetProperties)
+{
+    {
+        SCOPE_CYCLE_COUNTER(STAT_GenerateSpriteData);
+
+        const FNiagaraDataSet& DataSet = EmitterInst->GetData();
+        if (!Job.DataBuffer)
+            return;
+
+        const FNiagaraDataBuffer& ParticleData = *Job.DataBuffer;
+        const int32 ParticleCount = ParticleData.GetNumInstances();
+
+        if (ParticleCount < 1)
+            return;
+
+		//Add a box mesh, it stays in the slot across frames like the particle meshes
+		
+        FSlateVertex* VertexData;
+        SlateIndex* IndexData;
+
+        const int32 RenderDataIndex = Job.RenderDataIndices[0];
+        if (NiagaraWidget->GetResidentRenderDataBuffers(RenderDataIndex, &SpriteQuadGeometry, &VertexData, &IndexData, 4, 6))
+        {
+            VertexData[0].Position = FVector2D(-10, -10);
+            VertexData[0].Color = FColor(255, 0, 0, 255);
+            VertexData[0].TexCoords[0] = 0;
+            VertexData[0].TexCoords[1] = 0;
+            VertexData[0].TexCoords[2] = 0;
+            VertexData[0].TexCoords[3] = 0;
+
+            VertexData[1].Position = FVector2D(10, -10);
+            VertexData[1].Color = FColor(255, 0, 0, 255);
+            VertexData[1].TexCoords[0] = 1;
+            VertexData[1].TexCoords[1] = 0;
+            VertexData[1].TexCoords[2] = 0;
+            VertexData[1].TexCoords[3] = 0;
+
+            VertexData[2].Position = FVector2D(10, 10);
+            VertexData[2].Color = FColor(255, 0, 0, 255);
+            VertexData[2].TexCoords[0] = 1;
+            VertexData[2].TexCoords[1] = 1;
+            VertexData[2].TexCoords[2] = 0;
+            VertexData[2].TexCoords[3] = 0;
+
+            VertexData[3].Position = FVector2D(-10, 10);
+            VertexData[3].Color = FColor(255, 0, 0, 255);
+            VertexData[3].TexCoords[0] = 0;
+            VertexData[3].TexCoords[1] = 1;
+            VertexData[3].TexCoords[2] = 0;
+            VertexData[3].TexCoords[3] = 0;
+
+            IndexData[0] = 0;
+            IndexData[1] = 1;
+            IndexData[2] = 2;
+
+            IndexData[3] = 0;
+            IndexData[4] = 2;
+            IndexData[5] = 3;
         }
-        NiagaraWidget->AddRenderRun(RenderDataIndex, 0, InstanceData.Num());
-        NiagaraWidget->UpdatePerInstanceBuffer(RenderDataIndex, InstanceData);
+		
+		
+        const FNiagaraUIFloatStream<3> PositionData(DataSet, ParticleData, SpriteRenderer->PositionBinding.GetDataSetBindableVariable().GetName());
+        const FNiagaraUIFloatStream<4> ColorData(DataSet, ParticleData, SpriteRenderer->ColorBinding.GetDataSetBindableVariable().GetName(), 1.f, 1.f, 1.f, 1.f);
+        const FNiagaraUIFloatStream<3> VelocityData(DataSet, ParticleData, SpriteRenderer->VelocityBinding.GetDataSetBindableVariable().GetName());
+        const FNiagaraUIFloatStream<2> SizeData(DataSet, ParticleData, SpriteRenderer->SpriteSizeBinding.GetDataSetBindableVariable().GetName());
+        const FNiagaraUIFloatStream<1> RotationData(DataSet, ParticleData, SpriteRenderer->SpriteRotationBinding.GetDataSetBindableVariable().GetName());
+        const FNiagaraUIFloatStream<1> SubImageData(DataSet, ParticleData, SpriteRenderer->SubImageIndexBinding.GetDataSetBindableVariable().GetName());
+
+        // Systems simulated below the frame rate are drawn between their last two simulation steps
+        const FNiagaraDataBuffer& PreviousParticleData = Job.PreviousDataBuffer ? *Job.PreviousDataBuffer : ParticleData;
+        const FNiagaraUIFloatStream<3> PreviousPositionData(DataSet, PreviousParticleData, SpriteRenderer->PositionBinding.GetDataSetBindableVariable().GetName());
+        const FNiagaraUIFloatStream<4> PreviousColorData(DataSet, PreviousParticleData, SpriteRenderer->ColorBinding.GetDataSetBindableVariable().GetName(), 1.f, 1.f, 1.f, 1.f);
+        const FNiagaraUIFloatStream<1> PreviousRotationData(DataSet, PreviousParticleData, SpriteRenderer->SpriteRotationBinding.GetDataSetBindableVariable().GetName());
+        const FNiagaraUIParticleInterpolation Interpolation(DataSet, ParticleData, Job.PreviousDataBuffer, Job.InterpolationAlpha, Job.Renderer->SortBuffers.PreviousIndexByID);
+
+        FSlateInstanceBufferData& InstanceData = NiagaraWidget->GetInstanceData(RenderDataIndex);
+
+        const FNiagaraUISpriteKernelContext Context = {
+            Job, Interpolation,
+            PositionData, PreviousPositionData, ColorData, PreviousColorData, VelocityData, SizeData, RotationData, PreviousRotationData, SubImageData,
+            ComponentTransform.GetLocation(), ComponentTransform.GetRotation(), SlateLayoutTransform.GetScale(),
+            WidgetProperties->FakeDepthScaleDistance,
+            CVarNiagaraUICullAlphaThreshold.GetValueOnAnyThread(), CVarNiagaraUICullMinPixelSize.GetValueOnAnyThread(),
+            NiagaraUISubImageGrid(SpriteRenderer->SubImageSize)
+        };
+
+        // The per-particle loop is specialized on the settings which stay the same for the whole frame
+        int32 KernelFlags = 0;
+        KernelFlags |= EmitterInst->GetCachedEmitter()->bLocalSpace ? SpriteKernelLocalSpace : 0;
+        KernelFlags |= SpriteRenderer->Alignment == ENiagaraSpriteAlignment::VelocityAligned ? SpriteKernelVelocityAligned : 0;
+        KernelFlags |= WidgetProperties->FakeDepthScale ? SpriteKernelFakeDepth : 0;
+        KernelFlags |= SpriteRenderer->SubImageSize != FVector2D(1.f, 1.f) ? SpriteKernelSubImages : 0;
+
+        const FNiagaraUIFloatStream<1> CustomSortingData(DataSet, ParticleData, SpriteRenderer->CustomSortingBinding.GetDataSetBindableVariable().GetName());
+        const int32* ParticleOrder = SortParticles(Job.Renderer->SortBuffers, SpriteRenderer->SortMode, PositionData, CustomSortingData, ParticleCount);
+
+        int32 NumRendered = ParticleCount;
+        ParticleOrder = TruncateToBudget(Job, ParticleOrder, NumRendered);
+
+        const int32 NumCulled = SpriteKernels[KernelFlags](Context, InstanceData, NumRendered, ParticleOrder);
+        INC_DWORD_STAT_BY(STAT_NiagaraUICulledSprites, NumCulled);
+        Job.NumFilledRenderData = 1;
     }
    
 
 }
 
-void UNiagaraUIComponent::AddRibbonRendererData(SNiagaraUISystemWidget* NiagaraWidget, TSharedRef<const FNiagaraEmitterInstance, ESPMode::ThreadSafe> EmitterInst, UNiagaraRibbonRendererProperties* RibbonRenderer, const FSlateLayoutTransform& SlateLayoutTransform, const FTransform& ComponentTransform, const FNiagaraWidgetProperties* WidgetProperties)
+void UNiagaraUIComponent::AddRibbonRendererData(SNiagaraUISystemWidget* NiagaraWidget, FNiagaraUIRendererJob& Job, const TSharedRef<const FNiagaraEmitterInstance, ESPMode::ThreadSafe>& EmitterInst, UNiagaraRibbonRendererProperties* RibbonRenderer, const FSlateLayoutTransform& SlateLayoutTransform, const FTransform& ComponentTransform, const FNiagaraWidgetProperties* WidgetProperties)
 {
 	SCOPE_CYCLE_COUNTER(STAT_GenerateRibbonData);
 	
-	FNiagaraDataSet& DataSet = EmitterInst->GetData();
-	if (!DataSet.IsCurrentDataValid())
-	{
+	const FNiagaraDataSet& DataSet = EmitterInst->GetData();
+	if (!Job.DataBuffer)
 		return;
-	}
-	FNiagaraDataBuffer& ParticleData = DataSet.GetCurrentDataChecked();
+
+	const FNiagaraDataBuffer& ParticleData = *Job.DataBuffer;
 	const int32 ParticleCount = ParticleData.GetNumInstances();
 
 	if (ParticleCount < 2)
@@ -369,13 +1255,17 @@ void UNiagaraUIComponent::AddRibbonRendererData(SNiagaraUISystemWidget* NiagaraW
 	
 
 
-	const auto SortKeyReader = RibbonRenderer->SortKeyDataSetAccessor.GetReader(DataSet);
+	// Particles are linked by RibbonLinkOrder when the emitter writes it, by normalized age otherwise
+	const FNiagaraUIFloatStream<1> LinkOrderData(DataSet, ParticleData, RibbonRenderer->RibbonLinkOrderBinding.GetDataSetBindableVariable().GetName());
+	const FNiagaraUIFloatStream<1> NormalizedAgeData(DataSet, ParticleData, NiagaraUIRibbonNormalizedAgeName(*RibbonRenderer));
+	const FNiagaraUIFloatStream<1>& SortKeyData = LinkOrderData.IsValid() ? LinkOrderData : NormalizedAgeData;
 
-	const auto PositionData		= RibbonRenderer->PositionDataSetAccessor.GetReader(DataSet);
-	const auto ColorData		= FNiagaraDataSetAccessor<FLinearColor>::CreateReader(DataSet, RibbonRenderer->ColorBinding.GetDataSetBindableVariable().GetName());
-	const auto RibbonWidthData	= RibbonRenderer->SizeDataSetAccessor.GetReader(DataSet);
-	
-	const auto RibbonFullIDData = RibbonRenderer->RibbonFullIDDataSetAccessor.GetReader(DataSet);
+	const FNiagaraUIFloatStream<3> PositionData(DataSet, ParticleData, RibbonRenderer->PositionBinding.GetDataSetBindableVariable().GetName());
+	const FNiagaraUIFloatStream<4> ColorData(DataSet, ParticleData, RibbonRenderer->ColorBinding.GetDataSetBindableVariable().GetName(), 1.f, 1.f, 1.f, 1.f);
+	const FNiagaraUIFloatStream<1> RibbonWidthData(DataSet, ParticleData, RibbonRenderer->RibbonWidthBinding.GetDataSetBindableVariable().GetName());
+
+	// Only FNiagaraID ribbon IDs split the particles into multiple ribbons
+	const FNiagaraUIInt32Stream<2> RibbonFullIDData(DataSet, ParticleData, RibbonRenderer->RibbonIdBinding.GetDataSetBindableVariable().GetName());
 
     const bool LocalSpace = EmitterInst->GetCachedEmitter()->bLocalSpace;
     const bool FullIDs = RibbonFullIDData.IsValid();
@@ -391,7 +1281,7 @@ void UNiagaraUIComponent::AddRibbonRendererData(SNiagaraUISystemWidget* NiagaraW
 
 	auto GetParticlePosition2D = [&LocalSpace , &ComponentPos,&ComponentRot, &LayoutScale, &WidgetAbsolutePosition, &PositionData](int32 Index)
 	{
-        const FVector Position3D = PositionData.GetSafe(Index, FVector::ZeroVector);
+        const FVector Position3D = PositionData.GetVector(Index);
         FVector ComponentRelative = LocalSpace ? ComponentRot.RotateVector(Position3D) : Position3D - ComponentPos;
         FVector WidgetRelative = ComponentRelative * LayoutScale;
         return  FVector2D(WidgetAbsolutePosition.X + WidgetRelative.X, -WidgetAbsolutePosition.Z - WidgetRelative.Z);
@@ -400,30 +1290,42 @@ void UNiagaraUIComponent::AddRibbonRendererData(SNiagaraUISystemWidget* NiagaraW
 
 	auto GetParticleColor = [&ColorData](int32 Index)
 	{
-		return ColorData.GetSafe(Index, FLinearColor::White);
+		return ColorData.GetColor(Index);
 	};
 	
 	auto GetParticleWidth = [&SlateLayoutTransform ,&RibbonWidthData](int32 Index)
 	{
 		
-		return RibbonWidthData.GetSafe(Index, 0.f) * SlateLayoutTransform.GetScale();
+		return RibbonWidthData.Get(Index) * SlateLayoutTransform.GetScale();
 	};
 
 	
 
-	auto AddRibbonVerts = [&](TArray<int32>& RibbonIndices)
+	const float CullAlphaThreshold = CVarNiagaraUICullAlphaThreshold.GetValueOnAnyThread();
+	const float CullMinPixelSize = CVarNiagaraUICullMinPixelSize.GetValueOnAnyThread();
+	int32 NumCulledSegments = 0;
+
+	// Segments whose quad misses the culling rect, or which are transparent or thinner than a pixel at both ends, get no triangles
+	auto IsSegmentCulled = [&](const FSlateVertex* SegmentVertices, float StartAlpha, float EndAlpha, float StartWidth, float EndWidth)
+	{
+		if (FMath::Max(StartAlpha, EndAlpha) < CullAlphaThreshold || FMath::Max(StartWidth, EndWidth) < CullMinPixelSize)
+			return true;
+
+		FVector2D Min = SegmentVertices[0].Position;
+		FVector2D Max = SegmentVertices[0].Position;
+		for (int32 Vertex = 1; Vertex < 4; ++Vertex)
+		{
+			Min = FVector2D::Min(Min, SegmentVertices[Vertex].Position);
+			Max = FVector2D::Max(Max, SegmentVertices[Vertex].Position);
+		}
+		return Max.X < Job.CullingRect.Left || Min.X > Job.CullingRect.Right || Max.Y < Job.CullingRect.Top || Min.Y > Job.CullingRect.Bottom;
+	};
+
+	// Writes one ribbon into the shared buffers of its chunk, FirstVertex is the offset of the ribbon in the chunk.
+	// Returns the number of indices written, culled segments are left out
+	auto AddRibbonVerts = [&](const TArrayView<int32>& RibbonIndices, FSlateVertex* VertexData, SlateIndex* IndexData, int32 FirstVertex)
 	{
 		const int32 numParticlesInRibbon = RibbonIndices.Num();
-		if (numParticlesInRibbon < 3)
-			return;
-		
-		FSlateVertex* VertexData;	
-		SlateIndex* IndexData;
-	
-		FSlateBrush Brush;
-		UMaterialInterface* SpriteMaterial = RibbonRenderer->Material;
-		
-		NiagaraWidget->AddRenderData(&VertexData, &IndexData, SpriteMaterial, (numParticlesInRibbon - 1) * 2, (numParticlesInRibbon - 2) * 6);
 		
 		int32 CurrentVertexIndex = 0;
 		int32 CurrentIndexIndex = 0;
@@ -455,8 +1357,11 @@ void UNiagaraUIComponent::AddRibbonRendererData(SNiagaraUISystemWidget* NiagaraW
 		LastToCurrentVector *= 1.f / LastToCurrentSize;
 		
 
-		const FColor InitialColor = GetParticleColor(StartDataIndex).ToFColor(true);
+		const FLinearColor InitialLinearColor = GetParticleColor(StartDataIndex);
+		const FColor InitialColor = InitialLinearColor.ToFColor(true);
 		const float InitialWidth = GetParticleWidth(StartDataIndex);
+		float LastAlpha = InitialLinearColor.A;
+		float LastWidth = InitialWidth;
 		
 		FVector2D InitialPositionArray[2];
 		InitialPositionArray[0] = LastToCurrentVector.GetRotated(90.f) * InitialWidth * 0.5f;
@@ -481,7 +1386,8 @@ void UNiagaraUIComponent::AddRibbonRendererData(SNiagaraUISystemWidget* NiagaraW
 			FVector2D CurrentToNextVector = NextPosition - CurrentPosition;
 			const float CurrentToNextSize = CurrentToNextVector.Size();		
 			CurrentWidth = GetParticleWidth(CurrentDataIndex);
-			FColor CurrentColor = GetParticleColor(CurrentDataIndex).ToFColor(true);
+			const FLinearColor CurrentLinearColor = GetParticleColor(CurrentDataIndex);
+			FColor CurrentColor = CurrentLinearColor.ToFColor(true);
 
 			// Normalize CurrToNextVec
 			CurrentToNextVector *= 1.f / CurrentToNextSize;
@@ -536,17 +1442,28 @@ void UNiagaraUIComponent::AddRibbonRendererData(SNiagaraUISystemWidget* NiagaraW
 				VertexData[CurrentVertexIndex + i].TexCoords[3] = TextureCoordinates1[i].Y;
 			}
 			
-			IndexData[CurrentIndexIndex] = CurrentVertexIndex - 2;
-			IndexData[CurrentIndexIndex + 1] = CurrentVertexIndex - 1;
-			IndexData[CurrentIndexIndex + 2] = CurrentVertexIndex;
-		
-			IndexData[CurrentIndexIndex + 3] = CurrentVertexIndex - 1;
-			IndexData[CurrentIndexIndex + 4] = CurrentVertexIndex;
-			IndexData[CurrentIndexIndex + 5] = CurrentVertexIndex + 1;
-			
+			if (IsSegmentCulled(VertexData + CurrentVertexIndex - 2, LastAlpha, CurrentLinearColor.A, LastWidth, CurrentWidth))
+			{
+				++NumCulledSegments;
+			}
+			else
+			{
+				const int32 ChunkVertexIndex = FirstVertex + CurrentVertexIndex;
+
+				IndexData[CurrentIndexIndex] = ChunkVertexIndex - 2;
+				IndexData[CurrentIndexIndex + 1] = ChunkVertexIndex - 1;
+				IndexData[CurrentIndexIndex + 2] = ChunkVertexIndex;
+
+				IndexData[CurrentIndexIndex + 3] = ChunkVertexIndex - 1;
+				IndexData[CurrentIndexIndex + 4] = ChunkVertexIndex;
+				IndexData[CurrentIndexIndex + 5] = ChunkVertexIndex + 1;
+
+				CurrentIndexIndex += 6;
+			}
 
 			CurrentVertexIndex += 2;
-			CurrentIndexIndex += 6;
+			LastAlpha = CurrentLinearColor.A;
+			LastWidth = CurrentWidth;
 			
 			CurrentIndex = NextIndex;
 			CurrentDataIndex = NextDataIndex;
@@ -559,64 +1476,192 @@ void UNiagaraUIComponent::AddRibbonRendererData(SNiagaraUISystemWidget* NiagaraW
 
 			++NextIndex;
 		}
+
+		return CurrentIndexIndex;
 	};
 
+	TArray<TArrayView<int32>, TInlineAllocator<1>> Ribbons;
+
+	// The order buffers are kept by the renderer, so the sort starts from last frame's order and nothing is allocated
+	FNiagaraUIParticleSortBuffers& SortBuffers = Job.Renderer->SortBuffers;
+	TArray<int32>& SortedIndices = SortBuffers.Indices;
+
+	SortBuffers.Keys.SetNumUninitialized(ParticleCount, false);
+	uint32* SortKeys = SortBuffers.Keys.GetData();
+	for (int32 i = 0; i < ParticleCount; ++i)
+	{
+		SortKeys[i] = NiagaraUISortKey(SortKeyData.Get(i));
+	}
+
 	if (!MultiRibbons)
 	{
-		TArray<int32> SortedIndices;
-		for (int32 i = 0; i < ParticleCount; ++i)
+		// Last frame's order is a permutation of the same indices only while the particle count stays the same
+		if (SortedIndices.Num() != ParticleCount)
 		{
-			SortedIndices.Add(i);
+			SortedIndices.SetNumUninitialized(ParticleCount, false);
+			for (int32 i = 0; i < ParticleCount; ++i)
+			{
+				SortedIndices[i] = i;
+			}
 		}
 
-		SortedIndices.Sort([&SortKeyReader](const int32& A, const int32& B) {	return (SortKeyReader[A] < SortKeyReader[B]); });
+		NiagaraUISortNearlySorted(SortedIndices.GetData(), ParticleCount, SortKeys);
 
-		AddRibbonVerts(SortedIndices);
+		Ribbons.Add(SortedIndices);
 	}
 	else
 	{
 		if (FullIDs)
 		{
-			TMap<FNiagaraID, TArray<int32>> MultiRibbonSortedIndices;
-
+			// Counting sort of the particles into their ribbons, the group of every particle is kept in IndicesScratch
+			TMap<FNiagaraID, int32>& RibbonGroups = SortBuffers.RibbonGroups;
+			TArray<FNiagaraID>& RibbonGroupIDs = SortBuffers.RibbonGroupIDs;
+			TArray<int32>& RibbonGroupOffsets = SortBuffers.RibbonGroupOffsets;
+			RibbonGroups.Reset();
+			RibbonGroupIDs.Reset();
+			RibbonGroupOffsets.Reset();
+
+			SortBuffers.IndicesScratch.SetNumUninitialized(ParticleCount, false);
+			int32* ParticleGroups = SortBuffers.IndicesScratch.GetData();
 			for (int32 i = 0; i < ParticleCount; ++i)
 			{
-				TArray<int32>& Indices = MultiRibbonSortedIndices.FindOrAdd(RibbonFullIDData[i]);
-				Indices.Add(i);
+				FNiagaraID RibbonID;
+				RibbonID.Index = RibbonFullIDData.Get(i, 0);
+				RibbonID.AcquireTag = RibbonFullIDData.Get(i, 1);
+
+				const int32* ExistingGroup = RibbonGroups.Find(RibbonID);
+				if (ExistingGroup)
+				{
+					ParticleGroups[i] = *ExistingGroup;
+					++RibbonGroupOffsets[*ExistingGroup];
+				}
+				else
+				{
+					ParticleGroups[i] = RibbonGroupIDs.Num();
+					RibbonGroups.Add(RibbonID, RibbonGroupIDs.Num());
+					RibbonGroupIDs.Add(RibbonID);
+					RibbonGroupOffsets.Add(1);
+				}
 			}
 
 			// Sort the ribbons by ID so that the draw order stays consistent.
-			MultiRibbonSortedIndices.KeySort(TLess<FNiagaraID>());
+			const int32 NumGroups = RibbonGroupIDs.Num();
+			TArray<int32, TInlineAllocator<64>> GroupOrder;
+			GroupOrder.SetNumUninitialized(NumGroups);
+			for (int32 Group = 0; Group < NumGroups; ++Group)
+			{
+				GroupOrder[Group] = Group;
+			}
+			Algo::Sort(GroupOrder, [&RibbonGroupIDs](int32 A, int32 B) { return RibbonGroupIDs[A] < RibbonGroupIDs[B]; });
+
+			// Counts become the first index of every group, then the particles are scattered in buffer order
+			int32 GroupStart = 0;
+			for (const int32 Group : GroupOrder)
+			{
+				const int32 GroupCount = RibbonGroupOffsets[Group];
+				RibbonGroupOffsets[Group] = GroupStart;
+				GroupStart += GroupCount;
+			}
+
+			SortedIndices.SetNumUninitialized(ParticleCount, false);
+			for (int32 i = 0; i < ParticleCount; ++i)
+			{
+				SortedIndices[RibbonGroupOffsets[ParticleGroups[i]]++] = i;
+			}
+
+			// The scatter moved every offset to the end of its group, which is the start of the next one
+			GroupStart = 0;
+			for (const int32 Group : GroupOrder)
+			{
+				const int32 GroupEnd = RibbonGroupOffsets[Group];
+				const int32 GroupCount = GroupEnd - GroupStart;
+				int32* GroupIndices = SortedIndices.GetData() + GroupStart;
+				GroupStart = GroupEnd;
+
+				// Particles of a ribbon are spawned and compacted in order, so the buffer order is already close to the link order
+				NiagaraUISortNearlySorted(GroupIndices, GroupCount, SortKeys);
+				Ribbons.Add(TArrayView<int32>(GroupIndices, GroupCount));
+			}
+		}
+	}
+
+	const int32 MaxChunkVertices = MaxRibbonChunkVertices;
+
+	int32 FirstChunkRibbon = 0;
+	int32 ChunkIndex = 0;
+
+	while (FirstChunkRibbon < Ribbons.Num() && ChunkIndex < Job.RenderDataIndices.Num())
+	{
+		int32 ChunkVertices = 0;
+		int32 ChunkIndices = 0;
+		int32 EndChunkRibbon = FirstChunkRibbon;
+
+		for (; EndChunkRibbon < Ribbons.Num(); ++EndChunkRibbon)
+		{
+			// Ribbons which wouldn't fit even an empty chunk are truncated
+			if (Ribbons[EndChunkRibbon].Num() * 2 > MaxChunkVertices)
+			{
+				Ribbons[EndChunkRibbon] = Ribbons[EndChunkRibbon].Slice(0, MaxChunkVertices / 2);
+			}
+
+			const int32 NumParticlesInRibbon = Ribbons[EndChunkRibbon].Num();
+			if (NumParticlesInRibbon < 3)
+				continue;
+
+			const int32 RibbonVertices = (NumParticlesInRibbon - 1) * 2;
+			if (ChunkVertices + RibbonVertices > MaxChunkVertices)
+				break;
+
+			ChunkVertices += RibbonVertices;
+			ChunkIndices += (NumParticlesInRibbon - 2) * 6;
+		}
 
-			for (TPair<FNiagaraID, TArray<int32>>& Pair : MultiRibbonSortedIndices)
+		FSlateVertex* VertexData;
+		SlateIndex* IndexData;
+		const int32 RenderDataIndex = Job.RenderDataIndices[ChunkIndex++];
+
+		if (NiagaraWidget->GetRenderDataBuffers(RenderDataIndex, &VertexData, &IndexData, ChunkVertices, ChunkIndices))
+		{
+			int32 FirstVertex = 0;
+			int32 FirstIndex = 0;
+
+			for (int32 RibbonIndex = FirstChunkRibbon; RibbonIndex < EndChunkRibbon; ++RibbonIndex)
+			{
+				const int32 NumParticlesInRibbon = Ribbons[RibbonIndex].Num();
+				if (NumParticlesInRibbon < 3)
+					continue;
+
+				// Indices of culled segments are compacted away, the next ribbon continues right after the written ones
+				FirstIndex += AddRibbonVerts(Ribbons[RibbonIndex], VertexData + FirstVertex, IndexData + FirstIndex, FirstVertex);
+				FirstVertex += (NumParticlesInRibbon - 1) * 2;
+			}
+
+			// Chunks without any visible segment are skipped, so the filled slots are swapped to the front
+			if (FirstIndex > 0)
 			{
-				TArray<int32>& SortedIndices = Pair.Value;
-				SortedIndices.Sort([&SortKeyReader](const int32& A, const int32& B) {	return (SortKeyReader[A] < SortKeyReader[B]); });
-				AddRibbonVerts(SortedIndices);
-			};
+				NiagaraWidget->TrimRenderData(RenderDataIndex, FirstVertex, FirstIndex);
+				Swap(Job.RenderDataIndices[Job.NumFilledRenderData++], Job.RenderDataIndices[ChunkIndex - 1]);
+			}
 		}
+
+		FirstChunkRibbon = EndChunkRibbon;
 	}
 
+	INC_DWORD_STAT_BY(STAT_NiagaraUICulledRibbonSegments, NumCulledSegments);
 }
 
 
-void UNiagaraUIComponent::AddMeshRendererData(SNiagaraUISystemWidget* NiagaraWidget, TSharedRef<const FNiagaraEmitterInstance, ESPMode::ThreadSafe> EmitterInst, class UNiagaraMeshRendererProperties* MeshRenderer, const FSlateLayoutTransform& SlateLayoutTransform, const FTransform& ComponentTransform, const FNiagaraWidgetProperties* WidgetProperties)
+void UNiagaraUIComponent::AddMeshRendererData(SNiagaraUISystemWidget* NiagaraWidget, FNiagaraUIRendererJob& Job, const TSharedRef<const FNiagaraEmitterInstance, ESPMode::ThreadSafe>& EmitterInst, class UNiagaraMeshRendererProperties* MeshRenderer, const FSlateLayoutTransform& SlateLayoutTransform, const FTransform& ComponentTransform, const FNiagaraWidgetProperties* WidgetProperties)
 {
     {
         SCOPE_CYCLE_COUNTER(STAT_GenerateSpriteData);
 
-        auto* Widget = Cast<UNiagaraSystemWidget>( GetOuter());
-        if (!Widget) return;
-        if (Widget->MeshData.Num() == 0) return;
-        FName CurrentMeshPackageName = MeshRenderer->ParticleMesh->GetPackage()->GetFName();
-        FSlateMeshData* CurrentMeshData =  Widget->MeshData.FindByPredicate([&](FSlateMeshData& MeshData){return MeshData.MeshPackageName == CurrentMeshPackageName;});
-        if (!CurrentMeshData) return;
-        FNiagaraDataSet& DataSet = EmitterInst->GetData();
-        if (!DataSet.IsCurrentDataValid())
-        {
+        const FSlateMeshData* CurrentMeshData = Job.MeshData;
+        const FNiagaraDataSet& DataSet = EmitterInst->GetData();
+        if (!Job.DataBuffer)
             return;
-        }
-        FNiagaraDataBuffer& ParticleData = DataSet.GetCurrentDataChecked();
+
+        const FNiagaraDataBuffer& ParticleData = *Job.DataBuffer;
         const int32 ParticleCount = ParticleData.GetNumInstances();
 
         if (ParticleCount < 1)
@@ -624,110 +1669,74 @@ void UNiagaraUIComponent::AddMeshRendererData(SNiagaraUISystemWidget* NiagaraWid
 
         
 
+        if (CurrentMeshData->Vertex.Num() < 1 || CurrentMeshData->Index.Num() < 1)
+            return;
+
+        // The mesh geometry stays in the slot across frames, it's copied only when the slot doesn't hold it yet
         FSlateVertex* VertexData;
         SlateIndex* IndexData;
-        FSlateBrush Brush;
-        UMaterialInterface* SpriteMaterial = MeshRenderer->OverrideMaterials[0].ExplicitMat;
-        uint32 RenderDataIndex = NiagaraWidget->AddRenderDataWithInstance(&VertexData, &IndexData, SpriteMaterial, CurrentMeshData->Vertex.Num(), CurrentMeshData->Index.Num());
-        for (int VertexNum = 0; VertexNum < CurrentMeshData->Vertex.Num(); ++VertexNum)
-        {
-            VertexData[VertexNum].Position = CurrentMeshData->Vertex[VertexNum];
-            VertexData[VertexNum].Color = CurrentMeshData->VertexColor[VertexNum];
-            VertexData[VertexNum].TexCoords[0] = CurrentMeshData->UV[VertexNum].X;
-            VertexData[VertexNum].TexCoords[1] = CurrentMeshData->UV[VertexNum].Y;
-        }
-        for (int IndexNum = 0; IndexNum < CurrentMeshData->Index.Num(); ++IndexNum)
+        const int32 RenderDataIndex = Job.RenderDataIndices[0];
+        if (NiagaraWidget->GetResidentRenderDataBuffers(RenderDataIndex, CurrentMeshData, &VertexData, &IndexData, CurrentMeshData->Vertex.Num(), CurrentMeshData->Index.Num()))
         {
-            IndexData[IndexNum] = CurrentMeshData->Index[IndexNum];
+            for (int VertexNum = 0; VertexNum < CurrentMeshData->Vertex.Num(); ++VertexNum)
+            {
+                VertexData[VertexNum].Position = CurrentMeshData->Vertex[VertexNum];
+                VertexData[VertexNum].Color = CurrentMeshData->VertexColor[VertexNum];
+                VertexData[VertexNum].TexCoords[0] = CurrentMeshData->UV[VertexNum].X;
+                VertexData[VertexNum].TexCoords[1] = CurrentMeshData->UV[VertexNum].Y;
+            }
+            for (int IndexNum = 0; IndexNum < CurrentMeshData->Index.Num(); ++IndexNum)
+            {
+                IndexData[IndexNum] = CurrentMeshData->Index[IndexNum];
+            }
         }
 
-        const auto PositionData = FNiagaraDataSetAccessor<FVector>::CreateReader(DataSet, MeshRenderer->PositionBinding.GetDataSetBindableVariable().GetName());
-        const auto ColorData = FNiagaraDataSetAccessor<FLinearColor>::CreateReader(DataSet, MeshRenderer->ColorBinding.GetDataSetBindableVariable().GetName());
-        const auto VelocityData = FNiagaraDataSetAccessor<FVector>::CreateReader(DataSet, MeshRenderer->VelocityBinding.GetDataSetBindableVariable().GetName());
-        const auto SizeData = FNiagaraDataSetAccessor<FVector>::CreateReader(DataSet, MeshRenderer->ScaleBinding.GetDataSetBindableVariable().GetName());
-        const auto RotationData = FNiagaraDataSetAccessor<FQuat>::CreateReader(DataSet, MeshRenderer->MeshOrientationBinding.GetDataSetBindableVariable().GetName());
-
-        bool LocalSpace = EmitterInst->GetCachedEmitter()->bLocalSpace;
-        FVector ComponentPos = ComponentTransform.GetLocation();
-        FQuat ComponentRot = ComponentTransform.GetRotation();
-        float ComponentRotAng = FMath::RadiansToDegrees(ComponentRot.GetAngle());
-        float LayoutScale = SlateLayoutTransform.GetScale();
-        FVector WidgetAbsolutePosition = ComponentPos * LayoutScale;
-
-        auto GetParticlePosition2D = [&LocalSpace, &LayoutScale, &WidgetAbsolutePosition, &ComponentPos, &ComponentRot, &PositionData](int32 Index)
-        {
-            const FVector Position3D = PositionData.GetSafe(Index, FVector::ZeroVector);
-            FVector ComponentRelative = LocalSpace ? ComponentRot.RotateVector(Position3D) : Position3D - ComponentPos;
-            FVector WidgetRelative = ComponentRelative * LayoutScale;
-            return  FVector2D(WidgetAbsolutePosition.X + WidgetRelative.X, -WidgetAbsolutePosition.Z - WidgetRelative.Z);
-        };
-
-        auto GetParticleDepth = [&PositionData](int32 Index)
-        {
-            return PositionData.GetSafe(Index, FVector::ZeroVector).Y;
-        };
+        const FNiagaraUIFloatStream<3> PositionData(DataSet, ParticleData, MeshRenderer->PositionBinding.GetDataSetBindableVariable().GetName());
+        const FNiagaraUIFloatStream<4> ColorData(DataSet, ParticleData, MeshRenderer->ColorBinding.GetDataSetBindableVariable().GetName(), 1.f, 1.f, 1.f, 1.f);
+        const FNiagaraUIFloatStream<3> VelocityData(DataSet, ParticleData, MeshRenderer->VelocityBinding.GetDataSetBindableVariable().GetName());
+        const FNiagaraUIFloatStream<3> SizeData(DataSet, ParticleData, MeshRenderer->ScaleBinding.GetDataSetBindableVariable().GetName());
+        const FNiagaraUIFloatStream<4> RotationData(DataSet, ParticleData, MeshRenderer->MeshOrientationBinding.GetDataSetBindableVariable().GetName(), 0.f, 0.f, 0.f, 1.f);
 
-        auto GetParticleColor = [&ColorData](int32 Index)
-        {
-            return ColorData.GetSafe(Index, FLinearColor::White);
-        };
+        const FNiagaraDataBuffer& PreviousParticleData = Job.PreviousDataBuffer ? *Job.PreviousDataBuffer : ParticleData;
+        const FNiagaraUIFloatStream<3> PreviousPositionData(DataSet, PreviousParticleData, MeshRenderer->PositionBinding.GetDataSetBindableVariable().GetName());
+        const FNiagaraUIFloatStream<4> PreviousColorData(DataSet, PreviousParticleData, MeshRenderer->ColorBinding.GetDataSetBindableVariable().GetName(), 1.f, 1.f, 1.f, 1.f);
+        const FNiagaraUIFloatStream<4> PreviousRotationData(DataSet, PreviousParticleData, MeshRenderer->MeshOrientationBinding.GetDataSetBindableVariable().GetName(), 0.f, 0.f, 0.f, 1.f);
+        const FNiagaraUIParticleInterpolation Interpolation(DataSet, ParticleData, Job.PreviousDataBuffer, Job.InterpolationAlpha, Job.Renderer->SortBuffers.PreviousIndexByID);
 
-        auto GetParticleVelocity = [&LocalSpace, &ComponentRot, &VelocityData](int32 Index)
-        {
-            const FVector Velocity3D = VelocityData.GetSafe(Index, FVector::ZeroVector);
-            return LocalSpace ? ComponentRot.RotateVector(Velocity3D) : Velocity3D;
-        };
+        FSlateInstanceBufferData& InstanceData = NiagaraWidget->GetInstanceData(RenderDataIndex);
 
-        auto GetParticleSize = [&SizeData](int32 Index)
+        // Mesh instances are scaled around their origin, so the farthest vertex bounds them. Data baked before the radius
+        // was stored needs it measured
+        float MeshRadius = CurrentMeshData->Radius;
+        if (MeshRadius <= 0.f)
         {
-            return SizeData.GetSafe(Index, FVector::ZeroVector);
-        };
+            for (const FVector2D& Vertex : CurrentMeshData->Vertex)
+            {
+                MeshRadius = FMath::Max(MeshRadius, Vertex.Size());
+            }
+        }
 
-        auto GetParticleRotation = [&RotationData](int32 Index)
-        {
-            return RotationData.GetSafe(Index, FQuat::Identity);
+        const FNiagaraUIMeshKernelContext Context = {
+            Job, Interpolation,
+            PositionData, PreviousPositionData, ColorData, PreviousColorData, VelocityData, SizeData, RotationData, PreviousRotationData,
+            ComponentTransform.GetLocation(), ComponentTransform.GetRotation(), SlateLayoutTransform.GetScale(),
+            MeshRadius,
+            CVarNiagaraUICullAlphaThreshold.GetValueOnAnyThread(), CVarNiagaraUICullMinPixelSize.GetValueOnAnyThread()
         };
 
-        FSlateInstanceBufferData InstanceData;
-
-        for (int ParticleIndex = 0; ParticleIndex < ParticleCount; ++ParticleIndex)
-        {
-
-            FVector2D ParticlePosition = GetParticlePosition2D(ParticleIndex);
-            FVector ParticleSize = GetParticleSize(ParticleIndex);
-            FVector ParticleScale = ParticleSize * SlateLayoutTransform.GetScale();
-            const FColor ParticleColor = GetParticleColor(ParticleIndex).ToFColor(false);
+        int32 KernelFlags = 0;
+        KernelFlags |= EmitterInst->GetCachedEmitter()->bLocalSpace ? MeshKernelLocalSpace : 0;
+        KernelFlags |= MeshRenderer->FacingMode == ENiagaraMeshFacingMode::Velocity ? MeshKernelVelocityFacing : 0;
 
-            float ParticleAngle = 0.f;
+        const FNiagaraUIFloatStream<1> CustomSortingData(DataSet, ParticleData, MeshRenderer->CustomSortingBinding.GetDataSetBindableVariable().GetName());
+        const int32* ParticleOrder = SortParticles(Job.Renderer->SortBuffers, MeshRenderer->SortMode, PositionData, CustomSortingData, ParticleCount);
 
-            if (MeshRenderer->FacingMode == ENiagaraMeshFacingMode::Velocity)
-            {
-                const FVector ParticleVelocity = GetParticleVelocity(ParticleIndex);
-                float Ang = FMath::Atan2(-ParticleVelocity.Z, ParticleVelocity.X);
-                ParticleAngle = FMath::RadiansToDegrees(Ang);
-            }
-            else
-            {
-                FQuat ParticleRotation = GetParticleRotation(ParticleIndex);
-                FVector rotvec = ParticleRotation.RotateVector(FVector(1, 0, 0));
-                float Ang = FMath::Atan2(-rotvec.Z, rotvec.X);
-                ParticleAngle = FMath::RadiansToDegrees(Ang);
-            }
-                       
-            FSlateVectorArtInstanceData ArtInstData;
-            FVector4& data = ArtInstData.GetData();
-            InitPack(data);
-            PackPosition(data, ParticlePosition);
-            PackRotation(data, ParticleAngle);
-            PackColor(data, ParticleColor);
-            PackScale(data, FVector2D(ParticleScale.X, ParticleScale.Z));
-            InstanceData.Add(ArtInstData.GetData());
+        int32 NumRendered = ParticleCount;
+        ParticleOrder = TruncateToBudget(Job, ParticleOrder, NumRendered);
 
-        }
-        NiagaraWidget->AddRenderRun(RenderDataIndex, 0, InstanceData.Num());
-        NiagaraWidget->UpdatePerInstanceBuffer(RenderDataIndex, InstanceData);
+        const int32 NumCulled = MeshKernels[KernelFlags](Context, InstanceData, NumRendered, ParticleOrder);
+        INC_DWORD_STAT_BY(STAT_NiagaraUICulledMeshes, NumCulled);
+        Job.NumFilledRenderData = 1;
     }
 
-}
-
-PRAGMA_ENABLE_OPTIMIZATION
\ No newline at end of file
+}
\ No newline at end of file
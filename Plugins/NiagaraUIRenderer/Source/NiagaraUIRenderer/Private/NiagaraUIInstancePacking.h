@@ -0,0 +1,264 @@
+// Copyright 2021 - Michal Smoleň
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Instance layouts decoded by the JJYY material functions, one FVector4 per particle. Slate's instance buffers have
+ * a fixed 16 byte stride, so the layouts only differ in how they spend the bits.
+ *
+ * ENiagaraUIInstanceFormat::Compact
+ *  X: position X in quarter pixels offset by 1000 (16 bit) | scale X high byte | scale X low 6 bits
+ *  Y: position Y in quarter pixels offset by 1000 (16 bit) | scale Y high byte | scale Y low 6 bits
+ *  Z: color R | color G | color B | color A high 6 bits
+ *  W: sub image index | sub image grid (SizeY * 16 + SizeX) | rotation high byte | rotation low 6 bits
+ *
+ * ENiagaraUIInstanceFormat::Wide, for large or high DPI screens and HDR colors. Has no sub images
+ *  X: position X in quarter pixels offset by 32768 (24 bit) | scale X high 6 bits
+ *  Y: position Y in quarter pixels offset by 32768 (24 bit) | scale Y high 6 bits
+ *  Z: color R | color G | color B | color exponent (3 bit) + rotation high 3 bits
+ *  W: scale X low byte | scale Y low byte | color A | rotation low 6 bits
+ *  Scale is in 1/32 units up to 511, rotation in 1/512 turns. RGB are multiplied by 2^exponent, up to 128.
+ *
+ * The two lowest bits of the top byte of every component are always 10, so the components never end up
+ * as denormals or NaNs on the GPU. Shaders/Private/NiagaraUIInstanceDecode.ush decodes both layouts.
+ */
+
+/** Structure of arrays input of the instance packing, filled by the particle loops */
+struct FNiagaraUIPackBatch
+{
+	static const int32 Capacity = 64;
+
+	FORCEINLINE bool IsFull() const { return Num == Capacity; }
+
+	FORCEINLINE void Add(const FVector2D& Position, const FVector2D& Scale, float InRotation, const FLinearColor& Color, float InSubImage)
+	{
+		PositionX[Num] = Position.X;
+		PositionY[Num] = Position.Y;
+		ScaleX[Num] = Scale.X;
+		ScaleY[Num] = Scale.Y;
+		Rotation[Num] = InRotation;
+		ColorR[Num] = Color.R;
+		ColorG[Num] = Color.G;
+		ColorB[Num] = Color.B;
+		ColorA[Num] = Color.A;
+		SubImage[Num] = InSubImage;
+		++Num;
+	}
+
+	float PositionX[Capacity];
+	float PositionY[Capacity];
+	float ScaleX[Capacity];
+	float ScaleY[Capacity];
+	float Rotation[Capacity];
+	float ColorR[Capacity];
+	float ColorG[Capacity];
+	float ColorB[Capacity];
+	float ColorA[Capacity];
+	float SubImage[Capacity];
+	int32 Num = 0;
+};
+
+FORCEINLINE uint8 NiagaraUISubImageGrid(const FVector2D& SubImageSize)
+{
+	return uint8((int32)SubImageSize.Y * 16 + (int32)SubImageSize.X);
+}
+
+// FMath::Fmod(Rotation, 360) wrapped to positive angles, written out step by step so the SIMD path can match it exactly
+FORCEINLINE float NiagaraUIWrapRotation(float Rotation)
+{
+	const float Div = Rotation / 360.f;
+	const float Quotient = FMath::Abs(Div) < FLOAT_NON_FRACTIONAL ? (float)(int32)Div : Div;
+	float IntPortion = 360.f * Quotient;
+	if (FMath::Abs(IntPortion) > FMath::Abs(Rotation))
+	{
+		IntPortion = Rotation;
+	}
+
+	float Angle = FMath::Clamp(Rotation - IntPortion, -360.f, 360.f);
+	if (Angle < 0.f)
+	{
+		Angle += 360.f;
+	}
+	return Angle;
+}
+
+FORCEINLINE uint32 NiagaraUIPackTopByte(uint32 Value)
+{
+	return ((Value & 0xFC) | 2) << 24;
+}
+
+// Reference implementation of the packing, used for the batch remainder
+FORCEINLINE void NiagaraUIPackInstance(FVector4& OutInstance, const FVector2D& Position, const FVector2D& Scale, float Rotation, const FLinearColor& Color, float SubImage, uint8 SubImageGrid)
+{
+	const FVector2D ClampedPosition = Position.ClampAxes(-1000.f, 15383.f);
+	const uint32 PositionX = uint32((ClampedPosition.X + 1000.f) * 4.0f);
+	const uint32 PositionY = uint32((ClampedPosition.Y + 1000.f) * 4.0f);
+
+	const FVector2D ClampedScale = Scale.ClampAxes(0.f, 127.f);
+	const uint32 SizeX = uint32(ClampedScale.X * 128.0f);
+	const uint32 SizeY = uint32(ClampedScale.Y * 128.0f);
+
+	const uint32 PackedRotation = uint32(NiagaraUIWrapRotation(Rotation) * 32.0f);
+	const FColor PackedColor = Color.ToFColor(false);
+
+	uint32* Words = reinterpret_cast<uint32*>(&OutInstance);
+	Words[0] = PositionX | ((SizeX >> 8) << 16) | NiagaraUIPackTopByte(SizeX);
+	Words[1] = PositionY | ((SizeY >> 8) << 16) | NiagaraUIPackTopByte(SizeY);
+	Words[2] = uint32(PackedColor.R) | (uint32(PackedColor.G) << 8) | (uint32(PackedColor.B) << 16) | NiagaraUIPackTopByte(PackedColor.A);
+	Words[3] = (uint32((int32)SubImage) & 0xFF) | (uint32(SubImageGrid) << 8) | ((PackedRotation >> 8) << 16) | NiagaraUIPackTopByte(PackedRotation);
+}
+
+FORCEINLINE void NiagaraUIPackInstancesScalar(const FNiagaraUIPackBatch& Batch, int32 FirstIndex, uint8 SubImageGrid, FVector4* OutInstances)
+{
+	for (int32 Index = FirstIndex; Index < Batch.Num; ++Index)
+	{
+		NiagaraUIPackInstance(OutInstances[Index],
+			FVector2D(Batch.PositionX[Index], Batch.PositionY[Index]),
+			FVector2D(Batch.ScaleX[Index], Batch.ScaleY[Index]),
+			Batch.Rotation[Index],
+			FLinearColor(Batch.ColorR[Index], Batch.ColorG[Index], Batch.ColorB[Index], Batch.ColorA[Index]),
+			Batch.SubImage[Index],
+			SubImageGrid);
+	}
+}
+
+// Stores 6 bits in the bits of the top byte not taken by the marker
+FORCEINLINE uint32 NiagaraUIPackTopBits(uint32 Bits)
+{
+	return NiagaraUIPackTopByte((Bits & 0x3F) << 2);
+}
+
+FORCEINLINE void NiagaraUIPackInstanceWide(FVector4& OutInstance, const FVector2D& Position, const FVector2D& Scale, float Rotation, const FLinearColor& Color)
+{
+	const FVector2D ClampedPosition = Position.ClampAxes(-32768.f, 4161535.f);
+	const uint32 PositionX = uint32((ClampedPosition.X + 32768.f) * 4.0f);
+	const uint32 PositionY = uint32((ClampedPosition.Y + 32768.f) * 4.0f);
+
+	const FVector2D ClampedScale = Scale.ClampAxes(0.f, 511.f);
+	const uint32 SizeX = uint32(ClampedScale.X * 32.0f);
+	const uint32 SizeY = uint32(ClampedScale.Y * 32.0f);
+
+	// 360 degrees wrap around to 0
+	const uint32 PackedRotation = uint32(NiagaraUIWrapRotation(Rotation) * (512.f / 360.f)) & 0x1FF;
+
+	// Smallest shared exponent which fits the brightest channel
+	const float MaxChannel = FMath::Max3(Color.R, Color.G, Color.B);
+	uint32 Exponent = 0;
+	while (Exponent < 7 && MaxChannel > float(1 << Exponent))
+	{
+		++Exponent;
+	}
+	const float ChannelScale = 255.999f / float(1 << Exponent);
+	const uint32 ColorR = uint32(FMath::Clamp(Color.R * ChannelScale, 0.f, 255.999f));
+	const uint32 ColorG = uint32(FMath::Clamp(Color.G * ChannelScale, 0.f, 255.999f));
+	const uint32 ColorB = uint32(FMath::Clamp(Color.B * ChannelScale, 0.f, 255.999f));
+	const uint32 ColorA = uint32(FMath::Clamp(Color.A, 0.f, 1.f) * 255.999f);
+
+	uint32* Words = reinterpret_cast<uint32*>(&OutInstance);
+	Words[0] = PositionX | NiagaraUIPackTopBits(SizeX >> 8);
+	Words[1] = PositionY | NiagaraUIPackTopBits(SizeY >> 8);
+	Words[2] = ColorR | (ColorG << 8) | (ColorB << 16) | NiagaraUIPackTopBits(Exponent | ((PackedRotation >> 6) << 3));
+	Words[3] = (SizeX & 0xFF) | ((SizeY & 0xFF) << 8) | (ColorA << 16) | NiagaraUIPackTopBits(PackedRotation);
+}
+
+// The wide layout is picked for precision over throughput and has no SIMD path
+FORCEINLINE void NiagaraUIPackInstancesWide(const FNiagaraUIPackBatch& Batch, FVector4* OutInstances)
+{
+	for (int32 Index = 0; Index < Batch.Num; ++Index)
+	{
+		NiagaraUIPackInstanceWide(OutInstances[Index],
+			FVector2D(Batch.PositionX[Index], Batch.PositionY[Index]),
+			FVector2D(Batch.ScaleX[Index], Batch.ScaleY[Index]),
+			Batch.Rotation[Index],
+			FLinearColor(Batch.ColorR[Index], Batch.ColorG[Index], Batch.ColorB[Index], Batch.ColorA[Index]));
+	}
+}
+
+FORCEINLINE VectorRegisterInt NiagaraUIPackTopByte(const VectorRegisterInt& Value, const VectorRegisterInt& TopByteMask, const VectorRegisterInt& TopByteMarker)
+{
+	return VectorShiftLeftImm(VectorIntOr(VectorIntAnd(Value, TopByteMask), TopByteMarker), 24);
+}
+
+/**
+ * Packs the batch four particles at a time through the VectorRegister abstraction (SSE on desktop, NEON on mobile).
+ * The output is bit identical with NiagaraUIPackInstance for finite inputs.
+ */
+inline void NiagaraUIPackInstances(const FNiagaraUIPackBatch& Batch, uint8 SubImageGrid, FVector4* OutInstances)
+{
+	const VectorRegister Zero = VectorZero();
+	const VectorRegister One = VectorOne();
+	const VectorRegister PositionMin = VectorSetFloat1(-1000.f);
+	const VectorRegister PositionMax = VectorSetFloat1(15383.f);
+	const VectorRegister PositionOffset = VectorSetFloat1(1000.f);
+	const VectorRegister PositionFactor = VectorSetFloat1(4.0f);
+	const VectorRegister ScaleMax = VectorSetFloat1(127.f);
+	const VectorRegister ScaleFactor = VectorSetFloat1(128.0f);
+	const VectorRegister FullCircle = VectorSetFloat1(360.f);
+	const VectorRegister NegativeFullCircle = VectorSetFloat1(-360.f);
+	const VectorRegister NonFractional = VectorSetFloat1(FLOAT_NON_FRACTIONAL);
+	const VectorRegister RotationFactor = VectorSetFloat1(32.0f);
+	const VectorRegister ColorFactor = VectorSetFloat1(255.999f);
+
+	const VectorRegisterInt LowByteMask = MakeVectorRegisterInt(0xFF, 0xFF, 0xFF, 0xFF);
+	const VectorRegisterInt TopByteMask = MakeVectorRegisterInt(0xFC, 0xFC, 0xFC, 0xFC);
+	const VectorRegisterInt TopByteMarker = MakeVectorRegisterInt(2, 2, 2, 2);
+	const int32 GridBits = int32(SubImageGrid) << 8;
+	const VectorRegisterInt Grid = MakeVectorRegisterInt(GridBits, GridBits, GridBits, GridBits);
+
+	int32 Index = 0;
+	for (; Index + 4 <= Batch.Num; Index += 4)
+	{
+		// Position and scale
+		const VectorRegister PositionX = VectorMin(VectorMax(VectorLoad(&Batch.PositionX[Index]), PositionMin), PositionMax);
+		const VectorRegister PositionY = VectorMin(VectorMax(VectorLoad(&Batch.PositionY[Index]), PositionMin), PositionMax);
+		const VectorRegisterInt PackedPositionX = VectorFloatToInt(VectorMultiply(VectorAdd(PositionX, PositionOffset), PositionFactor));
+		const VectorRegisterInt PackedPositionY = VectorFloatToInt(VectorMultiply(VectorAdd(PositionY, PositionOffset), PositionFactor));
+
+		const VectorRegisterInt SizeX = VectorFloatToInt(VectorMultiply(VectorMin(VectorMax(VectorLoad(&Batch.ScaleX[Index]), Zero), ScaleMax), ScaleFactor));
+		const VectorRegisterInt SizeY = VectorFloatToInt(VectorMultiply(VectorMin(VectorMax(VectorLoad(&Batch.ScaleY[Index]), Zero), ScaleMax), ScaleFactor));
+
+		const VectorRegisterInt Word0 = VectorIntOr(VectorIntOr(PackedPositionX, VectorShiftLeftImm(VectorShiftRightImmLogical(SizeX, 8), 16)), NiagaraUIPackTopByte(SizeX, TopByteMask, TopByteMarker));
+		const VectorRegisterInt Word1 = VectorIntOr(VectorIntOr(PackedPositionY, VectorShiftLeftImm(VectorShiftRightImmLogical(SizeY, 8), 16)), NiagaraUIPackTopByte(SizeY, TopByteMask, TopByteMarker));
+
+		// Color
+		const VectorRegisterInt ColorR = VectorFloatToInt(VectorMultiply(VectorMin(VectorMax(VectorLoad(&Batch.ColorR[Index]), Zero), One), ColorFactor));
+		const VectorRegisterInt ColorG = VectorFloatToInt(VectorMultiply(VectorMin(VectorMax(VectorLoad(&Batch.ColorG[Index]), Zero), One), ColorFactor));
+		const VectorRegisterInt ColorB = VectorFloatToInt(VectorMultiply(VectorMin(VectorMax(VectorLoad(&Batch.ColorB[Index]), Zero), One), ColorFactor));
+		const VectorRegisterInt ColorA = VectorFloatToInt(VectorMultiply(VectorMin(VectorMax(VectorLoad(&Batch.ColorA[Index]), Zero), One), ColorFactor));
+
+		const VectorRegisterInt Word2 = VectorIntOr(VectorIntOr(ColorR, VectorShiftLeftImm(ColorG, 8)), VectorIntOr(VectorShiftLeftImm(ColorB, 16), NiagaraUIPackTopByte(ColorA, TopByteMask, TopByteMarker)));
+
+		// Rotation, same steps as NiagaraUIWrapRotation
+		const VectorRegister Rotation = VectorLoad(&Batch.Rotation[Index]);
+		const VectorRegister Div = VectorDivide(Rotation, FullCircle);
+		const VectorRegister Quotient = VectorSelect(VectorCompareGT(NonFractional, VectorAbs(Div)), VectorIntToFloat(VectorFloatToInt(Div)), Div);
+		VectorRegister IntPortion = VectorMultiply(FullCircle, Quotient);
+		IntPortion = VectorSelect(VectorCompareGT(VectorAbs(IntPortion), VectorAbs(Rotation)), Rotation, IntPortion);
+		VectorRegister Angle = VectorMin(VectorMax(VectorSubtract(Rotation, IntPortion), NegativeFullCircle), FullCircle);
+		Angle = VectorSelect(VectorCompareGT(Zero, Angle), VectorAdd(Angle, FullCircle), Angle);
+		const VectorRegisterInt PackedRotation = VectorFloatToInt(VectorMultiply(Angle, RotationFactor));
+
+		const VectorRegisterInt SubImageIndex = VectorIntAnd(VectorFloatToInt(VectorLoad(&Batch.SubImage[Index])), LowByteMask);
+		const VectorRegisterInt Word3 = VectorIntOr(VectorIntOr(SubImageIndex, Grid), VectorIntOr(VectorShiftLeftImm(VectorShiftRightImmLogical(PackedRotation, 8), 16), NiagaraUIPackTopByte(PackedRotation, TopByteMask, TopByteMarker)));
+
+		// Transpose the four components into the instances
+		uint32 Words[4][4];
+		VectorIntStore(Word0, Words[0]);
+		VectorIntStore(Word1, Words[1]);
+		VectorIntStore(Word2, Words[2]);
+		VectorIntStore(Word3, Words[3]);
+
+		for (int32 Lane = 0; Lane < 4; ++Lane)
+		{
+			uint32* InstanceWords = reinterpret_cast<uint32*>(&OutInstances[Index + Lane]);
+			InstanceWords[0] = Words[0][Lane];
+			InstanceWords[1] = Words[1][Lane];
+			InstanceWords[2] = Words[2][Lane];
+			InstanceWords[3] = Words[3][Lane];
+		}
+	}
+
+	NiagaraUIPackInstancesScalar(Batch, Index, SubImageGrid, OutInstances);
+}
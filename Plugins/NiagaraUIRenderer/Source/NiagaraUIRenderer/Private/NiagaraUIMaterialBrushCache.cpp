@@ -0,0 +1,163 @@
+// Copyright 2021 - Michal Smoleň
+
+#include "NiagaraUIMaterialBrushCache.h"
+#include "NiagaraUIStats.h"
+#include "Materials/MaterialInterface.h"
+#include "Materials/MaterialInstanceDynamic.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CoreDelegates.h"
+#include "Framework/Application/SlateApplication.h"
+#include "Rendering/SlateRenderer.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Material Brushes"), STAT_NiagaraUIMaterialBrushes, STATGROUP_NiagaraUI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Material Brush Cache Hits"), STAT_NiagaraUIMaterialBrushHits, STATGROUP_NiagaraUI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Material Brush Cache Misses"), STAT_NiagaraUIMaterialBrushMisses, STATGROUP_NiagaraUI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Material Brush Cache Evictions"), STAT_NiagaraUIMaterialBrushEvictions, STATGROUP_NiagaraUI);
+
+static TAutoConsoleVariable<int32> CVarNiagaraUIMaterialBrushCacheBudget(
+	TEXT("NiagaraUI.MaterialBrushCacheBudget"),
+	256,
+	TEXT("Number of material brushes the Niagara UI keeps around when no widget uses them."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarNiagaraUIMaterialBrushEvictAfterFrames(
+	TEXT("NiagaraUI.MaterialBrushEvictAfterFrames"),
+	600,
+	TEXT("Material brushes no widget used for this many frames are evicted, which releases their materials and textures. 0 keeps them until the cache is over budget."),
+	ECVF_Default);
+
+// The cache is trimmed at the end of every this many frames
+static const uint64 MaterialBrushTrimInterval = 60;
+
+FNiagaraUIMaterialBrushCache& FNiagaraUIMaterialBrushCache::Get()
+{
+	static FNiagaraUIMaterialBrushCache Cache;
+	return Cache;
+}
+
+FNiagaraUIMaterialBrushCache::FNiagaraUIMaterialBrushCache()
+{
+	EndFrameHandle = FCoreDelegates::OnEndFrame.AddRaw(this, &FNiagaraUIMaterialBrushCache::OnEndFrame);
+}
+
+FNiagaraUIMaterialBrushCache::~FNiagaraUIMaterialBrushCache()
+{
+	FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+}
+
+void FNiagaraUIMaterialBrushCache::OnEndFrame()
+{
+	if (Entries.Num() > 0 && GFrameCounter % MaterialBrushTrimInterval == 0)
+	{
+		Trim();
+	}
+}
+
+TSharedPtr<FSlateMaterialBrush> FNiagaraUIMaterialBrushCache::FindOrCreate(UMaterialInterface* Material, FSlateResourceHandle& OutResourceHandle)
+{
+	check(IsInGameThread());
+
+	if (FEntry* Entry = Entries.Find(Material))
+	{
+		if (Entry->Material.IsValid() && Entry->MaterialInstance && Entry->Brush.IsValid())
+		{
+			// The renderer drops handles of resources it released, those are resolved again
+			if (!Entry->ResourceHandle.IsValid())
+			{
+				Entry->ResourceHandle = FSlateApplication::Get().GetRenderer()->GetResourceHandle(*Entry->Brush);
+			}
+
+			Entry->LastUsedFrame = GFrameCounter;
+			OutResourceHandle = Entry->ResourceHandle;
+			INC_DWORD_STAT(STAT_NiagaraUIMaterialBrushHits);
+			return Entry->Brush;
+		}
+	}
+
+	INC_DWORD_STAT(STAT_NiagaraUIMaterialBrushMisses);
+
+	FEntry NewEntry;
+	NewEntry.Material = Material;
+	NewEntry.MaterialInstance = UMaterialInstanceDynamic::Create(Material, GetTransientPackage());
+	NewEntry.Brush = MakeShareable(new FSlateMaterialBrush(*NewEntry.MaterialInstance, FVector2D(1.f, 1.f)));
+	NewEntry.ResourceHandle = FSlateApplication::Get().GetRenderer()->GetResourceHandle(*NewEntry.Brush);
+	NewEntry.LastUsedFrame = GFrameCounter;
+
+	TSharedPtr<FSlateMaterialBrush> Brush = NewEntry.Brush;
+	OutResourceHandle = NewEntry.ResourceHandle;
+	Entries.Add(Material, MoveTemp(NewEntry));
+
+	if (Entries.Num() > CVarNiagaraUIMaterialBrushCacheBudget.GetValueOnGameThread())
+	{
+		Trim();
+	}
+
+	SET_DWORD_STAT(STAT_NiagaraUIMaterialBrushes, Entries.Num());
+	return Brush;
+}
+
+void FNiagaraUIMaterialBrushCache::Trim()
+{
+	check(IsInGameThread());
+
+	const int32 EvictAfterFrames = CVarNiagaraUIMaterialBrushEvictAfterFrames.GetValueOnGameThread();
+
+	// Brushes whose only owner is the cache aren't drawn by any widget. Their materials can't be destroyed while the
+	// cache holds the instance, so staying unused for long is what evicts them
+	TArray<TWeakObjectPtr<UMaterialInterface>, TInlineAllocator<16>> Unused;
+	for (auto It = Entries.CreateIterator(); It; ++It)
+	{
+		FEntry& Entry = It.Value();
+		if (!Entry.Brush.IsUnique())
+		{
+			Entry.UnusedSinceFrame = 0;
+			continue;
+		}
+
+		if (Entry.UnusedSinceFrame == 0)
+		{
+			Entry.UnusedSinceFrame = GFrameCounter;
+		}
+
+		if (!Entry.Material.IsValid() || (EvictAfterFrames > 0 && GFrameCounter - Entry.UnusedSinceFrame >= (uint64)EvictAfterFrames))
+		{
+			It.RemoveCurrent();
+			INC_DWORD_STAT(STAT_NiagaraUIMaterialBrushEvictions);
+		}
+		else
+		{
+			Unused.Add(It.Key());
+		}
+	}
+
+	const int32 Budget = FMath::Max(CVarNiagaraUIMaterialBrushCacheBudget.GetValueOnGameThread(), 0);
+	const int32 NumToEvict = FMath::Min(Entries.Num() - Budget, Unused.Num());
+	if (NumToEvict > 0)
+	{
+		Unused.Sort([this](const TWeakObjectPtr<UMaterialInterface>& A, const TWeakObjectPtr<UMaterialInterface>& B)
+		{
+			return Entries[A].LastUsedFrame < Entries[B].LastUsedFrame;
+		});
+
+		for (int32 Index = 0; Index < NumToEvict; ++Index)
+		{
+			Entries.Remove(Unused[Index]);
+		}
+		INC_DWORD_STAT_BY(STAT_NiagaraUIMaterialBrushEvictions, NumToEvict);
+	}
+
+	SET_DWORD_STAT(STAT_NiagaraUIMaterialBrushes, Entries.Num());
+}
+
+void FNiagaraUIMaterialBrushCache::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	for (TPair<TWeakObjectPtr<UMaterialInterface>, FEntry>& Pair : Entries)
+	{
+		Collector.AddReferencedObject(Pair.Value.MaterialInstance);
+	}
+}
+
+FString FNiagaraUIMaterialBrushCache::GetReferencerName() const
+{
+	return TEXT("FNiagaraUIMaterialBrushCache");
+}
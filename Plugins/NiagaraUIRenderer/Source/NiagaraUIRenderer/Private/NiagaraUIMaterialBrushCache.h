@@ -0,0 +1,55 @@
+// Copyright 2021 - Michal Smoleň
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/GCObject.h"
+#include "SlateMaterialBrush.h"
+#include "Textures/SlateShaderResource.h"
+
+class UMaterialInterface;
+class UMaterialInstanceDynamic;
+
+/**
+ * Material brushes shared by all Niagara UI widgets, one dynamic material instance per source material.
+ * The instances are kept alive through the reference collector, and through their parent they keep the source material
+ * and its textures alive too. Brushes no widget held for NiagaraUI.MaterialBrushEvictAfterFrames frames are therefore
+ * evicted at the end of the frame, whatever the size of the cache, and the least recently used ones go first once the
+ * cache grows over NiagaraUI.MaterialBrushCacheBudget. Game thread only.
+ */
+class FNiagaraUIMaterialBrushCache : public FGCObject
+{
+public:
+	static FNiagaraUIMaterialBrushCache& Get();
+
+	FNiagaraUIMaterialBrushCache();
+	virtual ~FNiagaraUIMaterialBrushCache();
+
+	// Returns the brush of the material together with its renderer resource handle, which is resolved once per brush
+	TSharedPtr<FSlateMaterialBrush> FindOrCreate(UMaterialInterface* Material, FSlateResourceHandle& OutResourceHandle);
+
+	// Evicts brushes which stayed unused for too long, and unused brushes while the cache is over budget
+	void Trim();
+
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+
+	virtual FString GetReferencerName() const override;
+
+private:
+	void OnEndFrame();
+
+	struct FEntry
+	{
+		TWeakObjectPtr<UMaterialInterface> Material;
+		UMaterialInstanceDynamic* MaterialInstance = nullptr;
+		TSharedPtr<FSlateMaterialBrush> Brush;
+		FSlateResourceHandle ResourceHandle;
+		uint64 LastUsedFrame = 0;
+		// Frame the cache became the only owner of the brush, 0 while a widget holds it
+		uint64 UnusedSinceFrame = 0;
+	};
+
+	TMap<TWeakObjectPtr<UMaterialInterface>, FEntry> Entries;
+
+	FDelegateHandle EndFrameHandle;
+};
@@ -0,0 +1,44 @@
+// Copyright 2021 - Michal Smoleň
+
+#include "NiagaraUIMeshDataCache.h"
+#include "Misc/ScopeLock.h"
+
+FNiagaraUIMeshDataCache& FNiagaraUIMeshDataCache::Get()
+{
+	static FNiagaraUIMeshDataCache Cache;
+	return Cache;
+}
+
+FSlateMeshDataPtr FNiagaraUIMeshDataCache::Find(FName MeshPackageName, int32 LODIndex)
+{
+	FScopeLock Lock(&EntriesLock);
+
+	const FKey Key{ MeshPackageName, LODIndex };
+	if (const TWeakPtr<const FSlateMeshData, ESPMode::ThreadSafe>* Entry = Entries.Find(Key))
+	{
+		FSlateMeshDataPtr MeshData = Entry->Pin();
+		if (!MeshData.IsValid())
+		{
+			Entries.Remove(Key);
+		}
+		return MeshData;
+	}
+	return nullptr;
+}
+
+FSlateMeshDataPtr FNiagaraUIMeshDataCache::Add(FSlateMeshData&& MeshData, bool Replace)
+{
+	FScopeLock Lock(&EntriesLock);
+
+	const FKey Key{ MeshData.MeshPackageName, MeshData.LODIndex };
+	TWeakPtr<const FSlateMeshData, ESPMode::ThreadSafe>& Entry = Entries.FindOrAdd(Key);
+	if (!Replace)
+	{
+		if (FSlateMeshDataPtr ExistingMeshData = Entry.Pin())
+			return ExistingMeshData;
+	}
+
+	FSlateMeshDataPtr NewMeshData = MakeShared<const FSlateMeshData, ESPMode::ThreadSafe>(MoveTemp(MeshData));
+	Entry = NewMeshData;
+	return NewMeshData;
+}
@@ -0,0 +1,38 @@
+// Copyright 2021 - Michal Smoleň
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NiagaraSystemWidget.h"
+
+/**
+ * Process wide cache of baked UI mesh LODs, keyed by mesh package and LOD. Widgets hold the shared data, the cache only
+ * keeps weak references, so a mesh LOD is freed once the last widget using it is gone.
+ */
+class FNiagaraUIMeshDataCache
+{
+public:
+	static FNiagaraUIMeshDataCache& Get();
+
+	// Returns the data of the mesh LOD if any widget still holds it
+	FSlateMeshDataPtr Find(FName MeshPackageName, int32 LODIndex);
+
+	// Shares the mesh data under its package and LOD. Data already shared under the key is returned instead and the new
+	// copy is dropped, unless Replace is set, which is used when the mesh was just rebaked
+	FSlateMeshDataPtr Add(FSlateMeshData&& MeshData, bool Replace);
+
+private:
+	struct FKey
+	{
+		FName MeshPackageName;
+		int32 LODIndex;
+
+		bool operator==(const FKey& Other) const { return MeshPackageName == Other.MeshPackageName && LODIndex == Other.LODIndex; }
+
+		friend uint32 GetTypeHash(const FKey& Key) { return HashCombine(GetTypeHash(Key.MeshPackageName), ::GetTypeHash(Key.LODIndex)); }
+	};
+
+	FCriticalSection EntriesLock;
+
+	TMap<FKey, TWeakPtr<const FSlateMeshData, ESPMode::ThreadSafe>> Entries;
+};
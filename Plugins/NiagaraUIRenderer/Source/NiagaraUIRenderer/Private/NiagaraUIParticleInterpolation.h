@@ -0,0 +1,110 @@
+// Copyright 2021 - Michal Smoleň
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NiagaraUIParticleStreams.h"
+
+/**
+ * Blends particle attributes of the current data buffer with the same particles one simulation step earlier, for systems
+ * simulated below the frame rate. Particles are matched by their ID. Particles spawned in the last step and emitters
+ * without persistent IDs use their current state.
+ */
+struct FNiagaraUIParticleInterpolation
+{
+	FNiagaraUIParticleInterpolation(const FNiagaraDataSet& DataSet, const FNiagaraDataBuffer& Current, const FNiagaraDataBuffer* Previous, float InAlpha, TArray<int32>& PreviousIndexByIDScratch)
+		: CurrentIDs(DataSet, Current, GetIDName())
+		, PreviousIDs(DataSet, Previous ? *Previous : Current, GetIDName())
+		, PreviousIndexByID(PreviousIndexByIDScratch)
+		, Alpha(InAlpha)
+	{
+		Active = Previous && Previous != &Current && Alpha < 1.f && CurrentIDs.IsValid();
+		if (!Active)
+			return;
+
+		// ID indices are slots of the emitter's ID table, so the lookup stays as small as the particle count
+		const int32 PreviousCount = Previous->GetNumInstances();
+		int32 MaxIDIndex = INDEX_NONE;
+		for (int32 Index = 0; Index < PreviousCount; ++Index)
+		{
+			MaxIDIndex = FMath::Max(MaxIDIndex, PreviousIDs.Get(Index, 0));
+		}
+
+		PreviousIndexByID.Init(INDEX_NONE, MaxIDIndex + 1);
+		for (int32 Index = 0; Index < PreviousCount; ++Index)
+		{
+			PreviousIndexByID[PreviousIDs.Get(Index, 0)] = Index;
+		}
+	}
+
+	FNiagaraUIParticleInterpolation(const FNiagaraUIParticleInterpolation&) = delete;
+	FNiagaraUIParticleInterpolation& operator=(const FNiagaraUIParticleInterpolation&) = delete;
+
+	FORCEINLINE bool IsActive() const { return Active; }
+
+	// Index of the particle in the previous buffer, INDEX_NONE when it has no previous state
+	FORCEINLINE int32 FindPrevious(int32 Index) const
+	{
+		if (!Active)
+			return INDEX_NONE;
+
+		const int32 IDIndex = CurrentIDs.Get(Index, 0);
+		if (!PreviousIndexByID.IsValidIndex(IDIndex))
+			return INDEX_NONE;
+
+		// Freed ID slots are reused, the acquire tag tells the particles apart
+		const int32 PreviousIndex = PreviousIndexByID[IDIndex];
+		return PreviousIndex != INDEX_NONE && PreviousIDs.Get(PreviousIndex, 1) == CurrentIDs.Get(Index, 1) ? PreviousIndex : INDEX_NONE;
+	}
+
+	template<int32 NumComponents>
+	FORCEINLINE float GetFloat(const FNiagaraUIFloatStream<NumComponents>& Current, const FNiagaraUIFloatStream<NumComponents>& Previous, int32 Index) const
+	{
+		const int32 PreviousIndex = FindPrevious(Index);
+		return PreviousIndex == INDEX_NONE ? Current.Get(Index) : FMath::Lerp(Previous.Get(PreviousIndex), Current.Get(Index), Alpha);
+	}
+
+	// Angles wrapped by the simulation turn the short way instead of spinning back through the whole circle
+	FORCEINLINE float GetAngleDegrees(const FNiagaraUIFloatStream<1>& Current, const FNiagaraUIFloatStream<1>& Previous, int32 Index) const
+	{
+		const int32 PreviousIndex = FindPrevious(Index);
+		if (PreviousIndex == INDEX_NONE)
+			return Current.Get(Index);
+
+		const float PreviousAngle = Previous.Get(PreviousIndex);
+		return PreviousAngle + FMath::FindDeltaAngleDegrees(PreviousAngle, Current.Get(Index)) * Alpha;
+	}
+
+	template<int32 NumComponents>
+	FORCEINLINE FVector GetVector(const FNiagaraUIFloatStream<NumComponents>& Current, const FNiagaraUIFloatStream<NumComponents>& Previous, int32 Index) const
+	{
+		const int32 PreviousIndex = FindPrevious(Index);
+		return PreviousIndex == INDEX_NONE ? Current.GetVector(Index) : FMath::Lerp(Previous.GetVector(PreviousIndex), Current.GetVector(Index), Alpha);
+	}
+
+	FORCEINLINE FLinearColor GetColor(const FNiagaraUIFloatStream<4>& Current, const FNiagaraUIFloatStream<4>& Previous, int32 Index) const
+	{
+		const int32 PreviousIndex = FindPrevious(Index);
+		return PreviousIndex == INDEX_NONE ? Current.GetColor(Index) : FMath::Lerp(Previous.GetColor(PreviousIndex), Current.GetColor(Index), Alpha);
+	}
+
+	FORCEINLINE FQuat GetQuat(const FNiagaraUIFloatStream<4>& Current, const FNiagaraUIFloatStream<4>& Previous, int32 Index) const
+	{
+		const int32 PreviousIndex = FindPrevious(Index);
+		return PreviousIndex == INDEX_NONE ? Current.GetQuat(Index) : FQuat::Slerp(Previous.GetQuat(PreviousIndex), Current.GetQuat(Index), Alpha);
+	}
+
+private:
+	// Particle IDs are stored as their ID table index and acquire tag
+	static const FName& GetIDName()
+	{
+		static const FName IDName(TEXT("ID"));
+		return IDName;
+	}
+
+	const FNiagaraUIInt32Stream<2> CurrentIDs;
+	const FNiagaraUIInt32Stream<2> PreviousIDs;
+	TArray<int32>& PreviousIndexByID;
+	float Alpha;
+	bool Active = false;
+};
@@ -0,0 +1,124 @@
+// Copyright 2021 - Michal Smoleň
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NiagaraUIComponent.h"
+#include "NiagaraRibbonRendererProperties.h"
+#include "Algo/Sort.h"
+
+// Maps a float to a key whose unsigned order is the float order, negative values get all bits flipped
+FORCEINLINE uint32 NiagaraUISortKey(float Value)
+{
+	const uint32 Bits = *reinterpret_cast<const uint32*>(&Value);
+	return Bits ^ ((Bits & 0x80000000u) ? 0xFFFFFFFFu : 0x80000000u);
+}
+
+// Data set name of the attribute ribbon particles are linked by when the emitter doesn't write RibbonLinkOrder. Data set
+// attributes have no Particles namespace, so the name comes from the renderer's binding
+inline FName NiagaraUIRibbonNormalizedAgeName(const UNiagaraRibbonRendererProperties& RibbonRenderer)
+{
+	return RibbonRenderer.NormalizedAgeBinding.GetDataSetBindableVariable().GetName();
+}
+
+/**
+ * Stable ascending LSD radix sort of the particle indices by Buffers.Keys, one pass per key byte.
+ * All four histograms are built in one read of the keys, passes where every key has the same byte are skipped.
+ */
+inline void NiagaraUIRadixSort(FNiagaraUIParticleSortBuffers& Buffers)
+{
+	const int32 Num = Buffers.Keys.Num();
+	Buffers.Indices.SetNumUninitialized(Num, false);
+	if (Num == 0)
+		return;
+
+	Buffers.KeysScratch.SetNumUninitialized(Num, false);
+	Buffers.IndicesScratch.SetNumUninitialized(Num, false);
+
+	uint32 Histograms[4][256];
+	FMemory::Memzero(Histograms, sizeof(Histograms));
+
+	const uint32* Keys = Buffers.Keys.GetData();
+	int32* Indices = Buffers.Indices.GetData();
+	for (int32 Index = 0; Index < Num; ++Index)
+	{
+		const uint32 Key = Keys[Index];
+		++Histograms[0][Key & 0xFF];
+		++Histograms[1][(Key >> 8) & 0xFF];
+		++Histograms[2][(Key >> 16) & 0xFF];
+		++Histograms[3][Key >> 24];
+		Indices[Index] = Index;
+	}
+
+	uint32* SourceKeys = Buffers.Keys.GetData();
+	int32* SourceIndices = Buffers.Indices.GetData();
+	uint32* DestKeys = Buffers.KeysScratch.GetData();
+	int32* DestIndices = Buffers.IndicesScratch.GetData();
+	bool SortedInScratch = false;
+
+	for (int32 Pass = 0; Pass < 4; ++Pass)
+	{
+		const int32 Shift = Pass * 8;
+		uint32* Histogram = Histograms[Pass];
+		if (Histogram[(SourceKeys[0] >> Shift) & 0xFF] == (uint32)Num)
+			continue;
+
+		uint32 Offset = 0;
+		for (int32 Digit = 0; Digit < 256; ++Digit)
+		{
+			const uint32 Count = Histogram[Digit];
+			Histogram[Digit] = Offset;
+			Offset += Count;
+		}
+
+		for (int32 Index = 0; Index < Num; ++Index)
+		{
+			const uint32 Key = SourceKeys[Index];
+			const uint32 Dest = Histogram[(Key >> Shift) & 0xFF]++;
+			DestKeys[Dest] = Key;
+			DestIndices[Dest] = SourceIndices[Index];
+		}
+
+		Swap(SourceKeys, DestKeys);
+		Swap(SourceIndices, DestIndices);
+		SortedInScratch = !SortedInScratch;
+	}
+
+	if (SortedInScratch)
+	{
+		Swap(Buffers.Keys, Buffers.KeysScratch);
+		Swap(Buffers.Indices, Buffers.IndicesScratch);
+	}
+}
+
+/**
+ * Sorts Indices by Keys[Index] with an insertion sort, which is linear for orders that barely change between frames
+ * like ribbon links. Gives up after a few moves per element and falls back to a full sort, so shuffled input
+ * doesn't turn quadratic.
+ */
+inline void NiagaraUISortNearlySorted(int32* Indices, int32 Num, const uint32* Keys)
+{
+	const int64 MaxMoves = (int64)Num * 8;
+	int64 NumMoves = 0;
+
+	for (int32 SortedEnd = 1; SortedEnd < Num; ++SortedEnd)
+	{
+		const int32 Index = Indices[SortedEnd];
+		const uint32 Key = Keys[Index];
+
+		int32 Dest = SortedEnd;
+		while (Dest > 0 && Keys[Indices[Dest - 1]] > Key)
+		{
+			Indices[Dest] = Indices[Dest - 1];
+			--Dest;
+		}
+		Indices[Dest] = Index;
+
+		NumMoves += SortedEnd - Dest;
+		if (NumMoves > MaxMoves)
+		{
+			Algo::Sort(MakeArrayView(Indices, Num), [Keys](int32 A, int32 B) { return Keys[A] < Keys[B]; });
+			return;
+		}
+	}
+}
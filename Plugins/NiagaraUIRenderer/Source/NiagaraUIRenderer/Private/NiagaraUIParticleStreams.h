@@ -0,0 +1,131 @@
+// Copyright 2021 - Michal Smoleň
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NiagaraDataSet.h"
+
+/**
+ * Raw per-component view of one float attribute in a particle data buffer.
+ * Validity is resolved once when the stream is created. Missing attributes read their default value through
+ * a zero index mask, so the particle loops don't need to branch on it.
+ */
+template<int32 NumComponents>
+struct FNiagaraUIFloatStream
+{
+	static_assert(NumComponents > 0 && NumComponents <= 4, "Niagara UI float streams support 1 to 4 components");
+
+	FNiagaraUIFloatStream(const FNiagaraDataSet& DataSet, const FNiagaraDataBuffer& Buffer, const FName& VariableName, float Default0 = 0.f, float Default1 = 0.f, float Default2 = 0.f, float Default3 = 0.f)
+	{
+		Defaults[0] = Default0;
+		Defaults[1] = Default1;
+		Defaults[2] = Default2;
+		Defaults[3] = Default3;
+
+		for (int32 Component = 0; Component < NumComponents; ++Component)
+		{
+			Components[Component] = &Defaults[Component];
+		}
+
+		const FNiagaraDataSetCompiledData& CompiledData = DataSet.GetCompiledData();
+		const int32 VariableIndex = CompiledData.Variables.IndexOfByPredicate([&VariableName](const FNiagaraVariable& Variable) { return Variable.GetName() == VariableName; });
+		if (VariableIndex == INDEX_NONE)
+			return;
+
+		const FNiagaraVariableLayoutInfo& Layout = CompiledData.VariableLayouts[VariableIndex];
+		if (Layout.GetNumFloatComponents() < (uint32)NumComponents)
+			return;
+
+		for (int32 Component = 0; Component < NumComponents; ++Component)
+		{
+			Components[Component] = reinterpret_cast<const float*>(Buffer.GetComponentPtrFloat(Layout.FloatComponentStart + Component));
+		}
+		IndexMask = ~0;
+	}
+
+	// Streams point into their own defaults
+	FNiagaraUIFloatStream(const FNiagaraUIFloatStream&) = delete;
+	FNiagaraUIFloatStream& operator=(const FNiagaraUIFloatStream&) = delete;
+
+	FORCEINLINE bool IsValid() const { return IndexMask != 0; }
+
+	FORCEINLINE const float* GetComponent(int32 Component) const { return Components[Component]; }
+
+	FORCEINLINE float Get(int32 Index, int32 Component = 0) const { return Components[Component][Index & IndexMask]; }
+
+	FORCEINLINE FVector2D GetVector2D(int32 Index) const
+	{
+		static_assert(NumComponents >= 2, "Stream has not enough components");
+		return FVector2D(Get(Index, 0), Get(Index, 1));
+	}
+
+	FORCEINLINE FVector GetVector(int32 Index) const
+	{
+		static_assert(NumComponents >= 3, "Stream has not enough components");
+		return FVector(Get(Index, 0), Get(Index, 1), Get(Index, 2));
+	}
+
+	FORCEINLINE FLinearColor GetColor(int32 Index) const
+	{
+		static_assert(NumComponents == 4, "Stream has not enough components");
+		return FLinearColor(Get(Index, 0), Get(Index, 1), Get(Index, 2), Get(Index, 3));
+	}
+
+	FORCEINLINE FQuat GetQuat(int32 Index) const
+	{
+		static_assert(NumComponents == 4, "Stream has not enough components");
+		return FQuat(Get(Index, 0), Get(Index, 1), Get(Index, 2), Get(Index, 3));
+	}
+
+private:
+	const float* Components[NumComponents];
+	float Defaults[4];
+	int32 IndexMask = 0;
+};
+
+/**
+ * Raw per-component view of one int32 attribute in a particle data buffer. Works the same way as FNiagaraUIFloatStream.
+ */
+template<int32 NumComponents>
+struct FNiagaraUIInt32Stream
+{
+	static_assert(NumComponents > 0 && NumComponents <= 4, "Niagara UI int32 streams support 1 to 4 components");
+
+	FNiagaraUIInt32Stream(const FNiagaraDataSet& DataSet, const FNiagaraDataBuffer& Buffer, const FName& VariableName, int32 Default = 0)
+	{
+		for (int32 Component = 0; Component < NumComponents; ++Component)
+		{
+			Defaults[Component] = Default;
+			Components[Component] = &Defaults[Component];
+		}
+
+		const FNiagaraDataSetCompiledData& CompiledData = DataSet.GetCompiledData();
+		const int32 VariableIndex = CompiledData.Variables.IndexOfByPredicate([&VariableName](const FNiagaraVariable& Variable) { return Variable.GetName() == VariableName; });
+		if (VariableIndex == INDEX_NONE)
+			return;
+
+		const FNiagaraVariableLayoutInfo& Layout = CompiledData.VariableLayouts[VariableIndex];
+		if (Layout.GetNumInt32Components() < (uint32)NumComponents)
+			return;
+
+		for (int32 Component = 0; Component < NumComponents; ++Component)
+		{
+			Components[Component] = reinterpret_cast<const int32*>(Buffer.GetComponentPtrInt32(Layout.Int32ComponentStart + Component));
+		}
+		IndexMask = ~0;
+	}
+
+	FNiagaraUIInt32Stream(const FNiagaraUIInt32Stream&) = delete;
+	FNiagaraUIInt32Stream& operator=(const FNiagaraUIInt32Stream&) = delete;
+
+	FORCEINLINE bool IsValid() const { return IndexMask != 0; }
+
+	FORCEINLINE const int32* GetComponent(int32 Component) const { return Components[Component]; }
+
+	FORCEINLINE int32 Get(int32 Index, int32 Component = 0) const { return Components[Component][Index & IndexMask]; }
+
+private:
+	const int32* Components[NumComponents];
+	int32 Defaults[NumComponents];
+	int32 IndexMask = 0;
+};
@@ -0,0 +1,194 @@
+// Copyright 2021 - Michal Smoleň
+
+#include "NiagaraUIPrewarmSubsystem.h"
+#include "NiagaraUIComponent.h"
+#include "NiagaraUIStats.h"
+#include "NiagaraSystem.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<int32> CVarNiagaraUIPrewarmTicksPerFrame(
+	TEXT("NiagaraUI.PrewarmTicksPerFrame"),
+	4,
+	TEXT("Simulation steps every prewarming UI particle system advances per frame."),
+	ECVF_Default);
+
+// Step of the prewarm simulation
+static const float PrewarmTickSeconds = 1.f / 30.f;
+
+void UNiagaraUIPrewarmSubsystem::Deinitialize()
+{
+	for (FNiagaraUIPrewarmPool& Pool : Pools)
+	{
+		for (UNiagaraUIComponent* Component : Pool.Components)
+		{
+			DestroyPrewarmComponent(Component);
+		}
+	}
+	Pools.Reset();
+
+	Super::Deinitialize();
+}
+
+void UNiagaraUIPrewarmSubsystem::PrewarmSystem(UNiagaraSystem* System, int32 Count, float WarmupSeconds, bool TickWhenPaused)
+{
+	if (!System)
+		return;
+
+	FNiagaraUIPrewarmPool* Pool = FindPool(System, TickWhenPaused);
+	if (!Pool)
+	{
+		if (Count < 1)
+			return;
+
+		Pool = &Pools.AddDefaulted_GetRef();
+		Pool->System = System;
+		Pool->TickWhenPaused = TickWhenPaused;
+	}
+
+	Pool->Size = FMath::Max(Count, 0);
+	Pool->WarmupSeconds = FMath::Max(WarmupSeconds, 0.f);
+
+	while (Pool->Components.Num() > Pool->Size)
+	{
+		DestroyPrewarmComponent(Pool->Components.Pop(false));
+		Pool->WarmedSeconds.Pop(false);
+	}
+
+	if (Pool->Size == 0)
+	{
+		Pools.RemoveAtSwap(Pool - Pools.GetData());
+	}
+}
+
+UNiagaraUIComponent* UNiagaraUIPrewarmSubsystem::ClaimPrewarmed(UNiagaraSystem* System, bool TickWhenPaused)
+{
+	FNiagaraUIPrewarmPool* Pool = FindPool(System, TickWhenPaused);
+	if (!Pool || Pool->Components.Num() == 0)
+		return nullptr;
+
+	int32 WarmestIndex = 0;
+	for (int32 Index = 1; Index < Pool->WarmedSeconds.Num(); ++Index)
+	{
+		if (Pool->WarmedSeconds[Index] > Pool->WarmedSeconds[WarmestIndex])
+		{
+			WarmestIndex = Index;
+		}
+	}
+
+	UNiagaraUIComponent* Component = Pool->Components[WarmestIndex];
+	Pool->Components.RemoveAtSwap(WarmestIndex, 1, false);
+	Pool->WarmedSeconds.RemoveAtSwap(WarmestIndex, 1, false);
+
+	if (!Component || !Component->IsRegistered())
+		return nullptr;
+
+	// The component stays owned by the world, the claiming widget supplies the particle meshes and gets the render data
+	// presized on its first paint
+	Component->SetPaused(false);
+	Component->SetSuspendWhileHidden(true);
+	Component->InvalidateRendererCache();
+	return Component;
+}
+
+ETickableTickType UNiagaraUIPrewarmSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+bool UNiagaraUIPrewarmSubsystem::IsTickable() const
+{
+	return Pools.Num() > 0;
+}
+
+TStatId UNiagaraUIPrewarmSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UNiagaraUIPrewarmSubsystem, STATGROUP_NiagaraUI);
+}
+
+void UNiagaraUIPrewarmSubsystem::Tick(float DeltaTime)
+{
+	const int32 TicksPerFrame = FMath::Max(CVarNiagaraUIPrewarmTicksPerFrame.GetValueOnGameThread(), 1);
+
+	for (int32 PoolIndex = Pools.Num() - 1; PoolIndex >= 0; --PoolIndex)
+	{
+		FNiagaraUIPrewarmPool& Pool = Pools[PoolIndex];
+		if (!Pool.System)
+		{
+			for (UNiagaraUIComponent* Component : Pool.Components)
+			{
+				DestroyPrewarmComponent(Component);
+			}
+			Pools.RemoveAtSwap(PoolIndex);
+			continue;
+		}
+
+		// One new simulation per pool and frame, so refilling doesn't hitch either
+		if (Pool.Components.Num() < Pool.Size)
+		{
+			if (UNiagaraUIComponent* Component = CreatePrewarmComponent(Pool))
+			{
+				Pool.Components.Add(Component);
+				Pool.WarmedSeconds.Add(0.f);
+			}
+		}
+
+		for (int32 Index = 0; Index < Pool.Components.Num(); ++Index)
+		{
+			UNiagaraUIComponent* Component = Pool.Components[Index];
+			if (!Component || Component->IsPaused())
+				continue;
+
+			const float RemainingSeconds = Pool.WarmupSeconds - Pool.WarmedSeconds[Index];
+			if (RemainingSeconds > 0.f)
+			{
+				const int32 NumTicks = FMath::Min(TicksPerFrame, FMath::CeilToInt(RemainingSeconds / PrewarmTickSeconds));
+				Component->AdvanceSimulation(NumTicks, PrewarmTickSeconds);
+				Pool.WarmedSeconds[Index] += NumTicks * PrewarmTickSeconds;
+			}
+
+			// Warmed simulations wait paused, they would only repeat their steady state
+			if (Pool.WarmedSeconds[Index] >= Pool.WarmupSeconds)
+			{
+				Component->SetPaused(true);
+			}
+		}
+	}
+}
+
+FNiagaraUIPrewarmPool* UNiagaraUIPrewarmSubsystem::FindPool(UNiagaraSystem* System, bool TickWhenPaused)
+{
+	return Pools.FindByPredicate([System, TickWhenPaused](const FNiagaraUIPrewarmPool& Pool) { return Pool.System == System && Pool.TickWhenPaused == TickWhenPaused; });
+}
+
+UNiagaraUIComponent* UNiagaraUIPrewarmSubsystem::CreatePrewarmComponent(const FNiagaraUIPrewarmPool& Pool)
+{
+	UWorld* World = GetWorld();
+	if (!World || !World->PersistentLevel)
+		return nullptr;
+
+	// Owned by the world, the widget claiming it may be created long after
+	UNiagaraUIComponent* Component = NewObject<UNiagaraUIComponent>(World);
+	Component->SetAutoActivate(false);
+	Component->SetHiddenInGame(true);
+	Component->SetSuspendWhileHidden(false);
+	Component->RegisterComponentWithWorld(World);
+	Component->SetAsset(Pool.System);
+	Component->SetAutoDestroy(false);
+
+	if (Pool.TickWhenPaused)
+	{
+		Component->PrimaryComponentTick.bTickEvenWhenPaused = true;
+		Component->SetForceSolo(true);
+	}
+
+	Component->Activate(true);
+	return Component;
+}
+
+void UNiagaraUIPrewarmSubsystem::DestroyPrewarmComponent(UNiagaraUIComponent* Component)
+{
+	if (Component && Component->IsRegistered())
+	{
+		Component->UnregisterComponent();
+	}
+}
@@ -0,0 +1,76 @@
+// Copyright 2021 - Michal Smoleň
+
+#include "NiagaraUISharedSimulations.h"
+#include "NiagaraUIComponent.h"
+#include "NiagaraSystem.h"
+#include "Engine/World.h"
+
+FNiagaraUISharedSimulations& FNiagaraUISharedSimulations::Get()
+{
+	static FNiagaraUISharedSimulations SharedSimulations;
+	return SharedSimulations;
+}
+
+FNiagaraUISharedSimulations::FNiagaraUISharedSimulations()
+{
+	WorldCleanupHandle = FWorldDelegates::OnWorldCleanup.AddRaw(this, &FNiagaraUISharedSimulations::OnWorldCleanup);
+}
+
+FNiagaraUISharedSimulations::~FNiagaraUISharedSimulations()
+{
+	FWorldDelegates::OnWorldCleanup.Remove(WorldCleanupHandle);
+}
+
+UNiagaraUIComponent* FNiagaraUISharedSimulations::Acquire(UWorld* World, UNiagaraSystem* System, bool AutoActivate, bool TickWhenPaused, float SimulationRate, TFunctionRef<UNiagaraUIComponent*()> CreateComponent)
+{
+	check(IsInGameThread());
+
+	const FKey Key{ World, System, AutoActivate, TickWhenPaused, SimulationRate };
+	FEntry& Entry = Entries.FindOrAdd(Key);
+
+	// Components of worlds torn down without their widgets releasing them are replaced
+	UNiagaraUIComponent* Component = Entry.Component.Get();
+	if (!Component || !Component->IsRegistered())
+	{
+		Component = CreateComponent();
+		Entry.Component = Component;
+		Entry.NumSubscribers = 0;
+	}
+
+	++Entry.NumSubscribers;
+	return Component;
+}
+
+void FNiagaraUISharedSimulations::Release(UNiagaraUIComponent* Component)
+{
+	check(IsInGameThread());
+
+	for (auto It = Entries.CreateIterator(); It; ++It)
+	{
+		FEntry& Entry = It.Value();
+		if (Entry.Component.Get() != Component)
+			continue;
+
+		if (--Entry.NumSubscribers <= 0)
+		{
+			if (Component->IsRegistered())
+			{
+				Component->UnregisterComponent();
+			}
+			It.RemoveCurrent();
+		}
+		return;
+	}
+}
+
+void FNiagaraUISharedSimulations::OnWorldCleanup(UWorld* World, bool SessionEnded, bool CleanupResources)
+{
+	for (auto It = Entries.CreateIterator(); It; ++It)
+	{
+		const TWeakObjectPtr<UWorld>& EntryWorld = It.Key().World;
+		if (EntryWorld.Get() == World || !EntryWorld.IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
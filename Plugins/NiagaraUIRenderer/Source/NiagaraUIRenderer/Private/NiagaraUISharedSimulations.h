@@ -0,0 +1,62 @@
+// Copyright 2021 - Michal Smoleň
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UNiagaraUIComponent;
+class UNiagaraSystem;
+class UWorld;
+
+/**
+ * Niagara UI components simulated once for all widgets which share the simulation of the same system in a world.
+ * Widgets subscribe with Acquire and hold the component themselves, the registry only counts the subscribers and
+ * unregisters the component once the last one is gone. Game thread only.
+ */
+class FNiagaraUISharedSimulations
+{
+public:
+	static FNiagaraUISharedSimulations& Get();
+
+	FNiagaraUISharedSimulations();
+	~FNiagaraUISharedSimulations();
+
+	// Returns the simulation shared under the key, CreateComponent is called when there is none yet
+	UNiagaraUIComponent* Acquire(UWorld* World, UNiagaraSystem* System, bool AutoActivate, bool TickWhenPaused, float SimulationRate, TFunctionRef<UNiagaraUIComponent*()> CreateComponent);
+
+	// Drops a subscription taken by Acquire
+	void Release(UNiagaraUIComponent* Component);
+
+private:
+	// Drops the simulations of the world, its components are destroyed with it
+	void OnWorldCleanup(UWorld* World, bool SessionEnded, bool CleanupResources);
+
+	struct FKey
+	{
+		TWeakObjectPtr<UWorld> World;
+		TWeakObjectPtr<UNiagaraSystem> System;
+		bool AutoActivate;
+		bool TickWhenPaused;
+		float SimulationRate;
+
+		bool operator==(const FKey& Other) const
+		{
+			return World == Other.World && System == Other.System && AutoActivate == Other.AutoActivate && TickWhenPaused == Other.TickWhenPaused && SimulationRate == Other.SimulationRate;
+		}
+
+		friend uint32 GetTypeHash(const FKey& Key)
+		{
+			return HashCombine(HashCombine(HashCombine(GetTypeHash(Key.World), GetTypeHash(Key.System)), GetTypeHash(Key.SimulationRate)), (uint32)Key.AutoActivate | ((uint32)Key.TickWhenPaused << 1));
+		}
+	};
+
+	struct FEntry
+	{
+		TWeakObjectPtr<UNiagaraUIComponent> Component;
+		int32 NumSubscribers = 0;
+	};
+
+	TMap<FKey, FEntry> Entries;
+
+	FDelegateHandle WorldCleanupHandle;
+};
@@ -5,15 +5,43 @@
 #include "Materials/MaterialInstanceDynamic.h"
 #include "NiagaraWidgetProperties.h"
 #include "NiagaraUIComponent.h"
+#include "NiagaraUIMaterialBrushCache.h"
 
-TMap<UMaterialInterface*, TSharedPtr<FSlateMaterialBrush>> SNiagaraUISystemWidget::MaterialBrushMap;
+// Render data slots which weren't used for this many updates are released
+static const uint32 RenderDataReleaseDelay = 120;
+
+// Every this many updates the slots are shrunk to the high water mark of the last window
+static const uint32 RenderDataHighWaterWindow = 300;
+
+// Slots are shrunk only if their capacity is this many times bigger than the high water mark
+static const int32 RenderDataShrinkFactor = 2;
+
+template<typename ArrayType>
+static void ShrinkToHighWaterMark(ArrayType& Array, int32 HighWaterMark)
+{
+    if (Array.Max() <= FMath::Max(HighWaterMark, 1) * RenderDataShrinkFactor)
+        return;
+
+    // Only used with trivial element types, so the uninitialized resize is safe
+    const int32 CurrentNum = Array.Num();
+    Array.SetNumUninitialized(FMath::Max(HighWaterMark, CurrentNum), false);
+    Array.Shrink();
+    Array.SetNumUninitialized(CurrentNum, false);
+}
 
 void SNiagaraUISystemWidget::Construct(const FArguments& Args)
 {
+    OwnerWidget = Args._OwnerWidget;
 }
 
 SNiagaraUISystemWidget::~SNiagaraUISystemWidget()
 {
+    // Asynchronous generation may still write into the render data
+    if (UNiagaraUIComponent* NiagaraUIComponent = NiagaraComponent.Get())
+    {
+        NiagaraUIComponent->ReleaseAsyncWidget(this);
+    }
+
     ClearRenderData();
 }
 
@@ -36,100 +64,262 @@ int32 SNiagaraUISystemWidget::OnPaint(const FPaintArgs& Args, const FGeometry& A
     FTransform ComponentTransform(M3);
     NiagaraUIComponent->SetTransformationForUIRendering(ComponentTransform);
 
-    NiagaraUIComponent->RenderUI(const_cast<SNiagaraUISystemWidget*>(this), SlateLayoutTransform, ComponentTransform, &WidgetProperties);
+    NiagaraUIComponent->RenderUI(const_cast<SNiagaraUISystemWidget*>(this), SlateLayoutTransform, ComponentTransform, &WidgetProperties, MyCullingRect);
+
+    // Pooled render data stays in RenderData, without any run SMeshWidget would draw all of it
+    if (NumRenderRuns == 0)
+        return LayerId;
 
     return SMeshWidget::OnPaint(Args, AllottedGeometry, MyCullingRect, OutDrawElements, LayerId, InWidgetStyle, bParentEnabled);
 }
 
-void SNiagaraUISystemWidget::AddRenderData(FSlateVertex** OutVertexData, SlateIndex** OutIndexData, UMaterialInterface* Material, int32 NumVertexData, int32 NumIndexData)
+void SNiagaraUISystemWidget::BeginRenderDataUpdate()
 {
-    if (NumVertexData < 1 || NumIndexData < 1)
-        return;
-    
-    FRenderData& NewRenderData = RenderData[RenderData.Add(FRenderData())];
-
-    NewRenderData.VertexData.AddUninitialized(NumVertexData);
-    *OutVertexData = &NewRenderData.VertexData[0];
-    
-    NewRenderData.IndexData.AddUninitialized(NumIndexData);
-    *OutIndexData = &NewRenderData.IndexData[0];
+    ++RenderDataUpdateCounter;
 
-    if (Material)
+    // Release slots of emitters and renderers which aren't rendered anymore
+    for (int32 RenderDataIndex = 0; RenderDataIndex < RenderDataSlots.Num(); ++RenderDataIndex)
     {
-        NewRenderData.Brush = CreateSlateMaterialBrush(Material);
-        NewRenderData.RenderingResourceHandle = FSlateApplication::Get().GetRenderer()->GetResourceHandle(*NewRenderData.Brush);
+        const FRenderDataSlot& Slot = RenderDataSlots[RenderDataIndex];
+        if (Slot.InUse && RenderDataUpdateCounter - Slot.LastUsedUpdate > RenderDataReleaseDelay)
+        {
+            ReleaseRenderDataSlot(RenderDataIndex);
+        }
     }
-    AddRenderRun(RenderData.Num()-1,0,1);
-    FSlateInstanceBufferData InstanceBuffer;
-    InstanceBuffer.Add(FVector4());
-    UpdatePerInstanceBuffer(RenderData.Num() - 1, InstanceBuffer);
+}
 
+void SNiagaraUISystemWidget::BeginRenderDataSubmit()
+{
+    ClearRuns(1);
+    NumRenderRuns = 0;
 }
 
+void SNiagaraUISystemWidget::EndRenderDataUpdate()
+{
+    const bool ShrinkSlots = RenderDataUpdateCounter % RenderDataHighWaterWindow == 0;
+
+    for (int32 RenderDataIndex = 0; RenderDataIndex < RenderDataSlots.Num(); ++RenderDataIndex)
+    {
+        FRenderData& SlotRenderData = RenderData[RenderDataIndex];
+        FRenderDataSlot& Slot = RenderDataSlots[RenderDataIndex];
+        if (!Slot.InUse)
+            continue;
 
-int32 SNiagaraUISystemWidget::AddRenderDataWithInstance(FSlateVertex** OutVertexData, SlateIndex** OutIndexData, UMaterialInterface* Material, int32 NumVertexData, int32 NumIndexData)
+        const bool UsedThisUpdate = Slot.LastUsedUpdate == RenderDataUpdateCounter;
+        const int32 NumVertices = UsedThisUpdate ? SlotRenderData.VertexData.Num() : 0;
+        const int32 NumIndices = UsedThisUpdate ? SlotRenderData.IndexData.Num() : 0;
+        const int32 NumInstances = UsedThisUpdate ? Slot.NumSubmittedInstances : 0;
+
+        Slot.HighWaterVertices = FMath::Max(Slot.HighWaterVertices, NumVertices);
+        Slot.HighWaterIndices = FMath::Max(Slot.HighWaterIndices, NumIndices);
+
+        if (ShrinkSlots)
+        {
+            ShrinkToHighWaterMark(SlotRenderData.VertexData, Slot.HighWaterVertices);
+            ShrinkToHighWaterMark(SlotRenderData.IndexData, Slot.HighWaterIndices);
+            ShrinkToHighWaterMark(Slot.PendingVertexData, Slot.HighWaterVertices);
+            ShrinkToHighWaterMark(Slot.PendingIndexData, Slot.HighWaterIndices);
+
+            // Start a new window, so the slots can shrink again once the particle count drops
+            Slot.HighWaterVertices = NumVertices;
+            Slot.HighWaterIndices = NumIndices;
+            Slot.HighWaterInstances = NumInstances;
+        }
+    }
+}
+
+int32 SNiagaraUISystemWidget::ReserveRenderData(const FNiagaraUIRenderDataKey& Key, UMaterialInterface* Material, bool WithInstances)
+{
+    const int32 RenderDataIndex = FindOrAddRenderDataSlot(Key);
+    FRenderDataSlot& Slot = RenderDataSlots[RenderDataIndex];
+    Slot.WithInstances = WithInstances;
+
+    // The slot keeps its brush and handle while the material stays the same, so the batcher sees the same resource
+    // every frame and the brush isn't looked up again
+    FRenderData& SlotRenderData = RenderData[RenderDataIndex];
+    if (Material && (Slot.BrushMaterial != Material || !SlotRenderData.RenderingResourceHandle.IsValid()))
+    {
+        SlotRenderData.Brush = FNiagaraUIMaterialBrushCache::Get().FindOrCreate(Material, SlotRenderData.RenderingResourceHandle);
+        Slot.BrushMaterial = Material;
+    }
+    return RenderDataIndex;
+}
+
+bool SNiagaraUISystemWidget::GetRenderDataBuffers(int32 RenderDataIndex, FSlateVertex** OutVertexData, SlateIndex** OutIndexData, int32 NumVertexData, int32 NumIndexData)
 {
     if (NumVertexData < 1 || NumIndexData < 1)
-        return -1;
+        return false;
 
-    int32 RenderDataIndex = RenderData.Add(FRenderData());
-    FRenderData& NewRenderData = RenderData[RenderDataIndex];
+    FRenderDataSlot& Slot = RenderDataSlots[RenderDataIndex];
+    Slot.LastUsedUpdate = RenderDataUpdateCounter;
+    Slot.PendingWrittenUpdate = RenderDataUpdateCounter;
+    Slot.PendingResidentGeometry = nullptr;
 
-    NewRenderData.VertexData.AddUninitialized(NumVertexData);
-    *OutVertexData = &NewRenderData.VertexData[0];
+    // Never shrink here, the capacity is kept for the next frames
+    Slot.PendingVertexData.SetNumUninitialized(NumVertexData, false);
+    *OutVertexData = Slot.PendingVertexData.GetData();
 
-    NewRenderData.IndexData.AddUninitialized(NumIndexData);
-    *OutIndexData = &NewRenderData.IndexData[0];
+    Slot.PendingIndexData.SetNumUninitialized(NumIndexData, false);
+    *OutIndexData = Slot.PendingIndexData.GetData();
+    return true;
+}
+
+bool SNiagaraUISystemWidget::GetResidentRenderDataBuffers(int32 RenderDataIndex, const void* GeometrySource, FSlateVertex** OutVertexData, SlateIndex** OutIndexData, int32 NumVertexData, int32 NumIndexData)
+{
+    FRenderDataSlot& Slot = RenderDataSlots[RenderDataIndex];
+    const FRenderData& SlotRenderData = RenderData[RenderDataIndex];
 
-    if (Material)
+    // The counts catch sources which were rebuilt in place
+    if (Slot.ResidentGeometry == GeometrySource && SlotRenderData.VertexData.Num() == NumVertexData && SlotRenderData.IndexData.Num() == NumIndexData)
     {
-        NewRenderData.Brush = CreateSlateMaterialBrush(Material);
-        NewRenderData.RenderingResourceHandle = FSlateApplication::Get().GetRenderer()->GetResourceHandle(*NewRenderData.Brush);
+        Slot.LastUsedUpdate = RenderDataUpdateCounter;
+        return false;
     }
-    return RenderDataIndex;
+
+    if (!GetRenderDataBuffers(RenderDataIndex, OutVertexData, OutIndexData, NumVertexData, NumIndexData))
+        return false;
+
+    Slot.PendingResidentGeometry = GeometrySource;
+    return true;
 }
 
-void SNiagaraUISystemWidget::ClearRenderData()
+void SNiagaraUISystemWidget::TrimRenderData(int32 RenderDataIndex, int32 NumVertexData, int32 NumIndexData)
 {
-    RenderData.Empty();
+    FRenderDataSlot& Slot = RenderDataSlots[RenderDataIndex];
+    check(NumVertexData <= Slot.PendingVertexData.Num() && NumIndexData <= Slot.PendingIndexData.Num());
+
+    Slot.PendingVertexData.SetNum(NumVertexData, false);
+    Slot.PendingIndexData.SetNum(NumIndexData, false);
 }
 
-TSharedPtr<FSlateMaterialBrush> SNiagaraUISystemWidget::CreateSlateMaterialBrush(UMaterialInterface* Material)
+FSlateInstanceBufferData& SNiagaraUISystemWidget::GetInstanceData(int32 RenderDataIndex)
 {
-    UMaterialInterface* MaterialToUse = Material;
-    if (MaterialBrushMap.Contains(MaterialToUse))
+    FRenderDataSlot& Slot = RenderDataSlots[RenderDataIndex];
+
+    // The submitted array was moved to the render thread, the new one is allocated once at the size needed before
+    Slot.InstanceData.Reset(Slot.HighWaterInstances);
+    return Slot.InstanceData;
+}
+
+void SNiagaraUISystemWidget::SubmitRenderData(int32 RenderDataIndex)
+{
+    FRenderDataSlot& Slot = RenderDataSlots[RenderDataIndex];
+    FRenderData& SlotRenderData = RenderData[RenderDataIndex];
+
+    // The previous frame's buffers become the back buffers of the next generation, resident geometry stays in place
+    if (Slot.PendingWrittenUpdate == RenderDataUpdateCounter)
+    {
+        Swap(SlotRenderData.VertexData, Slot.PendingVertexData);
+        Swap(SlotRenderData.IndexData, Slot.PendingIndexData);
+        Slot.ResidentGeometry = Slot.PendingResidentGeometry;
+    }
+
+    if (!Slot.WithInstances)
     {
-        const auto MapElement = MaterialBrushMap.Find(MaterialToUse);
+        AddRenderRun(RenderDataIndex, 0, 1);
+        ++NumRenderRuns;
 
-        if (MapElement->IsValid() && MapElement->Get()->GetResourceObject()->IsValidLowLevel() && MapElement->Get()->GetResourceObject()->IsA<UMaterialInterface>())
+        // The single dummy instance survives in the pooled slot, so it's uploaded only once
+        if (!SlotRenderData.PerInstanceBuffer.IsValid() || SlotRenderData.PerInstanceBuffer->GetNumInstances() != 1)
         {
-            return *MapElement;
+            FSlateInstanceBufferData InstanceBuffer;
+            InstanceBuffer.Add(FVector4());
+            UpdatePerInstanceBuffer(RenderDataIndex, InstanceBuffer);
         }
+        return;
     }
-    
-    const auto MaterialInstanceDynamic = UMaterialInstanceDynamic::Create(MaterialToUse, GetTransientPackage());
-    TSharedPtr<FSlateMaterialBrush> NewElement = MakeShareable(new FSlateMaterialBrush(*MaterialInstanceDynamic, FVector2D(1.f, 1.f)));
 
-    MaterialBrushMap.Add(MaterialToUse, NewElement);
-    return NewElement;
+    const int32 NumInstances = Slot.InstanceData.Num();
+    Slot.NumSubmittedInstances = NumInstances;
+    Slot.HighWaterInstances = FMath::Max(Slot.HighWaterInstances, NumInstances);
+
+    if (NumInstances < 1)
+        return;
+
+    AddRenderRun(RenderDataIndex, 0, NumInstances);
+    ++NumRenderRuns;
+
+    // The instance buffer update moves the array into its render command, which leaves the slot's array empty
+    UpdatePerInstanceBuffer(RenderDataIndex, Slot.InstanceData);
 }
 
-void SNiagaraUISystemWidget::CheckForInvalidBrushes()
+void SNiagaraUISystemWidget::PresizeRenderData(const FNiagaraUIRenderDataKey& Key, int32 NumVertexData, int32 NumIndexData, int32 NumInstanceData)
 {
-    TArray<UMaterialInterface*> RemoveMaterials;
-    for (const auto& Brush : MaterialBrushMap)
+    const int32 RenderDataIndex = FindOrAddRenderDataSlot(Key);
+    FRenderData& SlotRenderData = RenderData[RenderDataIndex];
+    FRenderDataSlot& Slot = RenderDataSlots[RenderDataIndex];
+
+    SlotRenderData.VertexData.Reserve(NumVertexData);
+    SlotRenderData.IndexData.Reserve(NumIndexData);
+    Slot.PendingVertexData.Reserve(NumVertexData);
+    Slot.PendingIndexData.Reserve(NumIndexData);
+
+    Slot.HighWaterVertices = FMath::Max(Slot.HighWaterVertices, NumVertexData);
+    Slot.HighWaterIndices = FMath::Max(Slot.HighWaterIndices, NumIndexData);
+    Slot.HighWaterInstances = FMath::Max(Slot.HighWaterInstances, NumInstanceData);
+    Slot.LastUsedUpdate = RenderDataUpdateCounter;
+}
+
+void SNiagaraUISystemWidget::ClearRenderData()
+{
+    ClearRuns(1);
+    NumRenderRuns = 0;
+
+    RenderData.Empty();
+    RenderDataSlots.Empty();
+    RenderDataSlotMap.Empty();
+    FreeRenderDataSlots.Empty();
+}
+
+int32 SNiagaraUISystemWidget::FindOrAddRenderDataSlot(const FNiagaraUIRenderDataKey& Key)
+{
+    if (const int32* ExistingIndex = RenderDataSlotMap.Find(Key))
+        return *ExistingIndex;
+
+    int32 RenderDataIndex;
+    if (FreeRenderDataSlots.Num() > 0)
     {
-        if (Brush.Value.GetSharedReferenceCount() <= 1)
-        {
-            Brush.Value->GetResourceObject()->RemoveFromRoot();
-            RemoveMaterials.Add(Brush.Key);
-        }
+        RenderDataIndex = FreeRenderDataSlots.Pop(false);
     }
-
-    for (const auto MaterialToRemove : RemoveMaterials)
+    else
     {
-        MaterialBrushMap.Remove(MaterialToRemove);
+        RenderDataIndex = RenderData.Add(FRenderData());
+        RenderDataSlots.AddDefaulted();
     }
+
+    FRenderDataSlot& NewSlot = RenderDataSlots[RenderDataIndex];
+    NewSlot.Key = Key;
+    NewSlot.LastUsedUpdate = RenderDataUpdateCounter;
+    NewSlot.InUse = true;
+
+    check(RenderData.Num() == RenderDataSlots.Num());
+    RenderDataSlotMap.Add(Key, RenderDataIndex);
+    return RenderDataIndex;
+}
+
+void SNiagaraUISystemWidget::ReleaseRenderDataSlot(int32 RenderDataIndex)
+{
+    RenderDataSlotMap.Remove(RenderDataSlots[RenderDataIndex].Key);
+
+    RenderData[RenderDataIndex] = FRenderData();
+    RenderDataSlots[RenderDataIndex] = FRenderDataSlot();
+    FreeRenderDataSlots.Add(RenderDataIndex);
+}
+
+TSharedPtr<FSlateMaterialBrush> SNiagaraUISystemWidget::CreateSlateMaterialBrush(UMaterialInterface* Material)
+{
+    FSlateResourceHandle ResourceHandle;
+    return FNiagaraUIMaterialBrushCache::Get().FindOrCreate(Material, ResourceHandle);
+}
+
+void SNiagaraUISystemWidget::CheckForInvalidBrushes()
+{
+    FNiagaraUIMaterialBrushCache::Get().Trim();
+}
+
+bool SNiagaraUISystemWidget::HasResidentGeometry(const void* GeometrySource) const
+{
+    return RenderDataSlots.ContainsByPredicate([GeometrySource](const FRenderDataSlot& Slot) { return Slot.InUse && Slot.ResidentGeometry == GeometrySource; });
 }
 
 void SNiagaraUISystemWidget::SetNiagaraComponentReference(TWeakObjectPtr<UNiagaraUIComponent> NiagaraComponentIn, FNiagaraWidgetProperties Properties)
@@ -139,5 +329,11 @@ void SNiagaraUISystemWidget::SetNiagaraComponentReference(TWeakObjectPtr<UNiagar
 
     WidgetProperties = Properties;
 
+    if (UNiagaraUIComponent* PreviousComponent = NiagaraComponent.Get())
+    {
+        if (PreviousComponent != NiagaraComponentIn.Get())
+            PreviousComponent->ReleaseAsyncWidget(this);
+    }
+
     NiagaraComponent = NiagaraComponentIn;
 }
\ No newline at end of file
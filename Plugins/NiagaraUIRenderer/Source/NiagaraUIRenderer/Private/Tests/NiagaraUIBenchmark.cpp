@@ -0,0 +1,264 @@
+// Copyright 2021 - Michal Smoleň
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "NiagaraUITestWorld.h"
+#include "NiagaraSystemWidget.h"
+#include "NiagaraSystem.h"
+#include "Framework/Application/SlateApplication.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/ConfigCacheIni.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+/**
+ * Headless benchmark of the whole widget path: the systems listed in the [NiagaraUIBenchmark] section of the game config
+ * are shown by 1, 10, 100 and 1000 widgets in a virtual window. A fixed number of frames is stepped, each one ticking the
+ * world and painting the window, and the timings are written as CSV to Saved/Profiling/NiagaraUIBenchmark.
+ * Runs with -nullrhi, e.g. -ExecCmds="Automation RunTests NiagaraUI.Benchmark; Quit".
+ * The mean frame time of every system and widget count is checked against the budgets file, -NiagaraUIBenchmarkUpdateBudgets
+ * stores the measured times as the new budgets. Cases without a budget are warnings, CI runs with
+ * -NiagaraUIBenchmarkRequireBudgets (or RequireBudgets=True in the config) to fail them until the budgets are committed.
+ */
+
+static const TCHAR* BenchmarkConfigSection = TEXT("NiagaraUIBenchmark");
+
+static const FVector2D BenchmarkWindowSize(1920.f, 1080.f);
+
+static const float BenchmarkDeltaSeconds = 1.f / 60.f;
+
+// Milliseconds of one phase in every measured frame
+struct FNiagaraUIBenchmarkPhase
+{
+	void Add(uint64 Cycles)
+	{
+		FrameMs.Add(FPlatformTime::ToMilliseconds64(Cycles));
+	}
+
+	double GetMean() const
+	{
+		double Sum = 0.0;
+		for (double Ms : FrameMs)
+		{
+			Sum += Ms;
+		}
+		return FrameMs.Num() > 0 ? Sum / FrameMs.Num() : 0.0;
+	}
+
+	double GetPercentile(float Percentile) const
+	{
+		if (FrameMs.Num() == 0)
+			return 0.0;
+
+		TArray<double> Sorted = FrameMs;
+		Sorted.Sort();
+		return Sorted[FMath::Clamp(FMath::CeilToInt(Sorted.Num() * Percentile) - 1, 0, Sorted.Num() - 1)];
+	}
+
+	TArray<double> FrameMs;
+};
+
+struct FNiagaraUIBenchmarkResult
+{
+	FNiagaraUIBenchmarkPhase Simulate;
+	FNiagaraUIBenchmarkPhase Paint;
+	FNiagaraUIBenchmarkPhase Frame;
+
+	// Particles of all widgets after the last frame
+	int32 Particles = 0;
+
+	// Growth of the used physical memory from before the widgets were created until the last frame
+	double MemoryGrowthMB = 0.0;
+};
+
+static FNiagaraUIBenchmarkResult RunNiagaraUIBenchmark(UNiagaraSystem* System, int32 NumWidgets, int32 WarmupFrames, int32 Frames)
+{
+	FNiagaraUIBenchmarkResult Result;
+	const int64 UsedMemoryBefore = (int64)FPlatformMemory::GetStats().UsedPhysical;
+
+	FNiagaraUITestWorld TestWorld(TEXT("NiagaraUIBenchmark"), BenchmarkWindowSize);
+
+	// Widgets are laid out in a grid filling the window, so all of them are painted
+	const int32 NumColumns = FMath::CeilToInt(FMath::Sqrt((float)NumWidgets));
+	for (int32 WidgetIndex = 0; WidgetIndex < NumWidgets; ++WidgetIndex)
+	{
+		TestWorld.ShowWidget(TestWorld.ConstructWidget(System), NumColumns);
+	}
+
+	for (int32 FrameIndex = 0; FrameIndex < WarmupFrames + Frames; ++FrameIndex)
+	{
+		uint64 SimulateCycles, PaintCycles;
+		TestWorld.StepFrame(BenchmarkDeltaSeconds, SimulateCycles, PaintCycles);
+
+		if (FrameIndex >= WarmupFrames)
+		{
+			Result.Simulate.Add(SimulateCycles);
+			Result.Paint.Add(PaintCycles);
+			Result.Frame.Add(SimulateCycles + PaintCycles);
+		}
+	}
+
+	Result.Particles = TestWorld.GetNumParticles();
+	Result.MemoryGrowthMB = double((int64)FPlatformMemory::GetStats().UsedPhysical - UsedMemoryBefore) / (1024.0 * 1024.0);
+
+	return Result;
+}
+
+// Mean frame time budgets in milliseconds by "System,Widgets"
+static TMap<FString, double> LoadNiagaraUIBenchmarkBudgets(const FString& Path)
+{
+	TMap<FString, double> Budgets;
+
+	TArray<FString> Lines;
+	if (!FFileHelper::LoadFileToStringArray(Lines, *Path))
+		return Budgets;
+
+	// The first line is the header
+	for (int32 LineIndex = 1; LineIndex < Lines.Num(); ++LineIndex)
+	{
+		TArray<FString> Columns;
+		Lines[LineIndex].ParseIntoArray(Columns, TEXT(","));
+		if (Columns.Num() >= 3)
+		{
+			Budgets.Add(Columns[0] + TEXT(",") + Columns[1], FCString::Atod(*Columns[2]));
+		}
+	}
+	return Budgets;
+}
+
+static void SaveNiagaraUIBenchmarkBudgets(const FString& Path, TMap<FString, double> Budgets)
+{
+	Budgets.KeySort(TLess<FString>());
+
+	FString Csv = TEXT("System,Widgets,FrameMs\n");
+	for (const TPair<FString, double>& Budget : Budgets)
+	{
+		Csv += FString::Printf(TEXT("%s,%.3f\n"), *Budget.Key, Budget.Value);
+	}
+	FFileHelper::SaveStringToFile(Csv, *Path);
+}
+
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FNiagaraUIBenchmarkTest, "NiagaraUI.Benchmark", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::PerfFilter)
+
+void FNiagaraUIBenchmarkTest::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+	for (int32 NumWidgets : { 1, 10, 100, 1000 })
+	{
+		OutBeautifiedNames.Add(FString::Printf(TEXT("%d Widgets"), NumWidgets));
+		OutTestCommands.Add(FString::FromInt(NumWidgets));
+	}
+}
+
+bool FNiagaraUIBenchmarkTest::RunTest(const FString& Parameters)
+{
+	const int32 NumWidgets = FCString::Atoi(*Parameters);
+
+	if (!FSlateApplication::IsInitialized())
+	{
+		AddError(TEXT("The benchmark paints the widgets through Slate, which isn't initialized"));
+		return false;
+	}
+
+	TArray<FString> SystemPaths;
+	GConfig->GetArray(BenchmarkConfigSection, TEXT("Systems"), SystemPaths, GGameIni);
+	if (SystemPaths.Num() == 0)
+	{
+		AddError(FString::Printf(TEXT("No Systems listed in the [%s] section of the game config"), BenchmarkConfigSection));
+		return false;
+	}
+
+	int32 WarmupFrames = 30;
+	int32 Frames = 240;
+	float BudgetTolerance = 0.1f;
+	FString BudgetsFile = TEXT("Build/NiagaraUIBenchmark/Budgets.csv");
+	GConfig->GetInt(BenchmarkConfigSection, TEXT("WarmupFrames"), WarmupFrames, GGameIni);
+	GConfig->GetInt(BenchmarkConfigSection, TEXT("Frames"), Frames, GGameIni);
+	GConfig->GetFloat(BenchmarkConfigSection, TEXT("BudgetTolerance"), BudgetTolerance, GGameIni);
+	GConfig->GetString(BenchmarkConfigSection, TEXT("BudgetsFile"), BudgetsFile, GGameIni);
+	FParse::Value(FCommandLine::Get(), TEXT("NiagaraUIBenchmarkFrames="), Frames);
+	const bool UpdateBudgets = FParse::Param(FCommandLine::Get(), TEXT("NiagaraUIBenchmarkUpdateBudgets"));
+	bool RequireBudgets = false;
+	GConfig->GetBool(BenchmarkConfigSection, TEXT("RequireBudgets"), RequireBudgets, GGameIni);
+	RequireBudgets |= FParse::Param(FCommandLine::Get(), TEXT("NiagaraUIBenchmarkRequireBudgets"));
+
+	const FString BudgetsPath = FPaths::Combine(FPaths::ProjectDir(), BudgetsFile);
+	TMap<FString, double> Budgets = LoadNiagaraUIBenchmarkBudgets(BudgetsPath);
+
+	FString Csv = TEXT("System,Widgets,Frames,Particles,SimulateMs,SimulateP95Ms,PaintMs,PaintP95Ms,FrameMs,FrameP95Ms,FrameMaxMs,MemoryGrowthMB,BudgetFrameMs,WithinBudget\n");
+	for (const FString& SystemPath : SystemPaths)
+	{
+		UNiagaraSystem* System = LoadObject<UNiagaraSystem>(nullptr, *SystemPath);
+		if (!System)
+		{
+			AddError(FString::Printf(TEXT("Failed to load the Niagara system %s"), *SystemPath));
+			continue;
+		}
+
+#if WITH_EDITOR
+		System->WaitForCompilationComplete();
+#endif
+
+		const FNiagaraUIBenchmarkResult Result = RunNiagaraUIBenchmark(System, NumWidgets, WarmupFrames, Frames);
+		const double FrameMs = Result.Frame.GetMean();
+
+		// A case without particles measured widgets which never simulated
+		if (Result.Particles == 0)
+		{
+			AddError(FString::Printf(TEXT("%s with %d widgets: no particles after %d frames"), *System->GetName(), NumWidgets, WarmupFrames + Frames));
+		}
+
+		const FString BudgetKey = FString::Printf(TEXT("%s,%d"), *System->GetName(), NumWidgets);
+		const double* Budget = Budgets.Find(BudgetKey);
+		const bool WithinBudget = !Budget || FrameMs <= *Budget * (1.0 + BudgetTolerance);
+		if (!Budget && !UpdateBudgets)
+		{
+			const FString Message = FString::Printf(TEXT("%s with %d widgets: %.3f ms per frame, no budget in %s"), *System->GetName(), NumWidgets, FrameMs, *BudgetsFile);
+			if (RequireBudgets)
+			{
+				AddError(Message);
+			}
+			else
+			{
+				AddWarning(Message);
+			}
+		}
+		else if (!WithinBudget)
+		{
+			AddError(FString::Printf(TEXT("%s with %d widgets: %.3f ms per frame, over the budget of %.3f ms"), *System->GetName(), NumWidgets, FrameMs, *Budget));
+		}
+
+		Csv += FString::Printf(TEXT("%s,%d,%d,%d,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.2f,%.3f,%d\n"),
+			*System->GetName(), NumWidgets, Frames, Result.Particles,
+			Result.Simulate.GetMean(), Result.Simulate.GetPercentile(0.95f),
+			Result.Paint.GetMean(), Result.Paint.GetPercentile(0.95f),
+			FrameMs, Result.Frame.GetPercentile(0.95f), Result.Frame.GetPercentile(1.f),
+			Result.MemoryGrowthMB, Budget ? *Budget : 0.0, WithinBudget ? 1 : 0);
+
+		if (UpdateBudgets)
+		{
+			Budgets.Add(BudgetKey, FrameMs);
+		}
+	}
+
+	const FString CsvPath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Profiling"), TEXT("NiagaraUIBenchmark"), FString::Printf(TEXT("NiagaraUIBenchmark_%dWidgets.csv"), NumWidgets));
+	if (FFileHelper::SaveStringToFile(Csv, *CsvPath))
+	{
+		AddInfo(FString::Printf(TEXT("Results written to %s"), *CsvPath));
+	}
+	else
+	{
+		AddError(FString::Printf(TEXT("Failed to write %s"), *CsvPath));
+	}
+
+	if (UpdateBudgets)
+	{
+		SaveNiagaraUIBenchmarkBudgets(BudgetsPath, Budgets);
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,137 @@
+// Copyright 2021 - Michal Smoleň
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "NiagaraUIInstancePacking.h"
+
+// Fills every lane of the batch with edge values, cycling the attributes at different rates so every value meets
+// every other one somewhere in the batch
+static void FillEdgeCaseBatch(FNiagaraUIPackBatch& Batch)
+{
+	const float Positions[] = { -5000.f, -1000.f, -999.9f, -0.126f, 0.f, 0.126f, 1919.5f, 15383.f, 15383.9f, 1.0e7f, -1.0e7f };
+	const float Scales[] = { -1.f, 0.f, 0.0078f, 0.5f, 1.f, 13.37f, 126.99f, 127.f, 500.f };
+	const float Rotations[] = { -1.0e9f, -720.5f, -360.f, -359.99f, -0.001f, 0.f, 0.001f, 180.f, 359.99f, 360.f, 361.7f, 1.0e6f, 1.0e9f };
+	const float Colors[] = { -0.5f, 0.f, 0.0019f, 0.5f, 0.999f, 1.f, 1.5f, 4.f, 100.f, 200.f };
+	const float SubImages[] = { 0.f, 0.99f, 1.f, 7.5f, 15.f };
+
+	Batch.Num = 0;
+	for (int32 Index = 0; Index < FNiagaraUIPackBatch::Capacity; ++Index)
+	{
+		Batch.Add(
+			FVector2D(Positions[Index % UE_ARRAY_COUNT(Positions)], Positions[(Index * 7 + 3) % UE_ARRAY_COUNT(Positions)]),
+			FVector2D(Scales[Index % UE_ARRAY_COUNT(Scales)], Scales[(Index * 5 + 1) % UE_ARRAY_COUNT(Scales)]),
+			Rotations[Index % UE_ARRAY_COUNT(Rotations)],
+			FLinearColor(Colors[Index % UE_ARRAY_COUNT(Colors)], Colors[(Index * 3 + 1) % UE_ARRAY_COUNT(Colors)], Colors[(Index * 7 + 2) % UE_ARRAY_COUNT(Colors)], Colors[(Index * 9 + 5) % UE_ARRAY_COUNT(Colors)]),
+			SubImages[Index % UE_ARRAY_COUNT(SubImages)]);
+	}
+}
+
+// Same steps as NiagaraUIDecodeWideInstance in Shaders/Private/NiagaraUIInstanceDecode.ush
+static void DecodeWideInstance(const FVector4& Instance, FVector2D& OutPosition, FVector2D& OutScale, float& OutRotation, FLinearColor& OutColor)
+{
+	const uint32* Words = reinterpret_cast<const uint32*>(&Instance);
+
+	OutPosition = FVector2D(float(Words[0] & 0xFFFFFF), float(Words[1] & 0xFFFFFF)) * 0.25f - FVector2D(32768.f, 32768.f);
+
+	const uint32 SizeX = ((Words[0] >> 26) << 8) | (Words[3] & 0xFF);
+	const uint32 SizeY = ((Words[1] >> 26) << 8) | ((Words[3] >> 8) & 0xFF);
+	OutScale = FVector2D(float(SizeX), float(SizeY)) / 32.f;
+
+	const uint32 ColorBits = Words[2] >> 26;
+	const float ColorScale = float(1 << (ColorBits & 0x7)) / 255.f;
+	OutColor = FLinearColor(float(Words[2] & 0xFF) * ColorScale, float((Words[2] >> 8) & 0xFF) * ColorScale, float((Words[2] >> 16) & 0xFF) * ColorScale, float((Words[3] >> 16) & 0xFF) / 255.f);
+
+	const uint32 Rotation = ((ColorBits >> 3) << 6) | (Words[3] >> 26);
+	OutRotation = float(Rotation) * (360.f / 512.f);
+}
+
+// The two lowest bits of the top byte of every component have to stay 10, so none of them reads as a denormal or NaN on the GPU
+static bool HasMarkerBits(const FVector4& Instance)
+{
+	const uint32* Words = reinterpret_cast<const uint32*>(&Instance);
+	for (int32 Component = 0; Component < 4; ++Component)
+	{
+		if (((Words[Component] >> 24) & 0x3) != 2)
+			return false;
+	}
+	return true;
+}
+
+// The SIMD packing has to be bit identical with the scalar reference on every platform, and the wide layout has to
+// decode back to what was packed within its precision
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNiagaraUIInstancePackingTest, "NiagaraUI.InstancePacking", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ProductFilter)
+
+bool FNiagaraUIInstancePackingTest::RunTest(const FString& Parameters)
+{
+	FNiagaraUIPackBatch Batch;
+	FillEdgeCaseBatch(Batch);
+
+	const uint8 SubImageGrid = NiagaraUISubImageGrid(FVector2D(4.f, 4.f));
+
+	// Compact layout, the whole batch goes through the SIMD lanes
+	FVector4 SimdInstances[FNiagaraUIPackBatch::Capacity];
+	FVector4 ScalarInstances[FNiagaraUIPackBatch::Capacity];
+	NiagaraUIPackInstances(Batch, SubImageGrid, SimdInstances);
+	NiagaraUIPackInstancesScalar(Batch, 0, SubImageGrid, ScalarInstances);
+
+	for (int32 Index = 0; Index < Batch.Num; ++Index)
+	{
+		if (FMemory::Memcmp(&SimdInstances[Index], &ScalarInstances[Index], sizeof(FVector4)) != 0)
+		{
+			const uint32* SimdWords = reinterpret_cast<const uint32*>(&SimdInstances[Index]);
+			const uint32* ScalarWords = reinterpret_cast<const uint32*>(&ScalarInstances[Index]);
+			AddError(FString::Printf(TEXT("Instance %d (position %g %g, scale %g %g, rotation %g, color %g %g %g %g) packs to %08x %08x %08x %08x with SIMD and %08x %08x %08x %08x without"),
+				Index, Batch.PositionX[Index], Batch.PositionY[Index], Batch.ScaleX[Index], Batch.ScaleY[Index], Batch.Rotation[Index],
+				Batch.ColorR[Index], Batch.ColorG[Index], Batch.ColorB[Index], Batch.ColorA[Index],
+				SimdWords[0], SimdWords[1], SimdWords[2], SimdWords[3], ScalarWords[0], ScalarWords[1], ScalarWords[2], ScalarWords[3]));
+		}
+
+		TestTrue(FString::Printf(TEXT("Compact instance %d keeps the marker bits"), Index), HasMarkerBits(ScalarInstances[Index]));
+	}
+
+	// Wide layout round trip
+	FVector4 WideInstances[FNiagaraUIPackBatch::Capacity];
+	NiagaraUIPackInstancesWide(Batch, WideInstances);
+
+	for (int32 Index = 0; Index < Batch.Num; ++Index)
+	{
+		TestTrue(FString::Printf(TEXT("Wide instance %d keeps the marker bits"), Index), HasMarkerBits(WideInstances[Index]));
+
+		FVector2D Position, Scale;
+		float Rotation;
+		FLinearColor Color;
+		DecodeWideInstance(WideInstances[Index], Position, Scale, Rotation, Color);
+
+		const FVector2D ExpectedPosition = FVector2D(Batch.PositionX[Index], Batch.PositionY[Index]).ClampAxes(-32768.f, 4161535.f);
+		TestTrue(FString::Printf(TEXT("Wide instance %d position %s decodes to %s"), Index, *ExpectedPosition.ToString(), *Position.ToString()), Position.Equals(ExpectedPosition, 0.25f));
+
+		const FVector2D ExpectedScale = FVector2D(Batch.ScaleX[Index], Batch.ScaleY[Index]).ClampAxes(0.f, 511.f);
+		TestTrue(FString::Printf(TEXT("Wide instance %d scale %s decodes to %s"), Index, *ExpectedScale.ToString(), *Scale.ToString()), Scale.Equals(ExpectedScale, 1.f / 32.f));
+
+		// Rotations compare on the circle, 360 degrees wrap around to 0
+		const float ExpectedRotation = NiagaraUIWrapRotation(Batch.Rotation[Index]);
+		TestTrue(FString::Printf(TEXT("Wide instance %d rotation %g decodes to %g"), Index, ExpectedRotation, Rotation), FMath::Abs(FMath::FindDeltaAngleDegrees(ExpectedRotation, Rotation)) <= 360.f / 512.f);
+
+		// RGB keep 8 bits below the shared exponent, which covers up to 128
+		const FLinearColor ExpectedColor(
+			FMath::Clamp(Batch.ColorR[Index], 0.f, 128.f), FMath::Clamp(Batch.ColorG[Index], 0.f, 128.f), FMath::Clamp(Batch.ColorB[Index], 0.f, 128.f), FMath::Clamp(Batch.ColorA[Index], 0.f, 1.f));
+		float ColorStep = 1.f;
+		while (ColorStep < 128.f && ColorStep < FMath::Max3(ExpectedColor.R, ExpectedColor.G, ExpectedColor.B))
+		{
+			ColorStep *= 2.f;
+		}
+		const float ColorTolerance = ColorStep / 255.f + KINDA_SMALL_NUMBER;
+		const bool ColorMatches = FMath::IsNearlyEqual(Color.R, ExpectedColor.R, ColorTolerance)
+			&& FMath::IsNearlyEqual(Color.G, ExpectedColor.G, ColorTolerance)
+			&& FMath::IsNearlyEqual(Color.B, ExpectedColor.B, ColorTolerance)
+			&& FMath::IsNearlyEqual(Color.A, ExpectedColor.A, 1.f / 255.f + KINDA_SMALL_NUMBER);
+		TestTrue(FString::Printf(TEXT("Wide instance %d color %s decodes to %s"), Index, *ExpectedColor.ToString(), *Color.ToString()), ColorMatches);
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
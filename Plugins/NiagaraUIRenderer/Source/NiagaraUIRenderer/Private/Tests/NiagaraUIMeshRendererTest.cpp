@@ -0,0 +1,160 @@
+// Copyright 2021 - Michal Smoleň
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "NiagaraUITestWorld.h"
+#include "NiagaraSystemWidget.h"
+#include "NiagaraUIComponent.h"
+#include "NiagaraUIPrewarmSubsystem.h"
+#include "SNiagaraUISystemWidget.h"
+#include "NiagaraSystem.h"
+#include "NiagaraMeshRendererProperties.h"
+#include "Framework/Application/SlateApplication.h"
+
+static const TCHAR* MeshSystemPath = TEXT("/Game/Particles/NS_MeshRender.NS_MeshRender");
+
+static UNiagaraMeshRendererProperties* FindMeshRenderer(UNiagaraSystem* System)
+{
+	for (const FNiagaraEmitterHandle& EmitterHandle : System->GetEmitterHandles())
+	{
+		if (!EmitterHandle.GetInstance())
+			continue;
+
+		for (UNiagaraRendererProperties* Renderer : EmitterHandle.GetInstance()->GetRenderers())
+		{
+			if (UNiagaraMeshRendererProperties* MeshRenderer = Cast<UNiagaraMeshRendererProperties>(Renderer))
+			{
+				if (MeshRenderer->ParticleMesh)
+					return MeshRenderer;
+			}
+		}
+	}
+	return nullptr;
+}
+
+// Whether the last paint of the widget drew one of the LODs of the renderer's mesh baked by the widget
+static bool DrawsParticleMesh(FAutomationTestBase& Test, UNiagaraSystemWidget* Widget, UNiagaraMeshRendererProperties* MeshRenderer)
+{
+	const TArray<FSlateMeshDataPtr>* MeshLODs = Widget->FindMeshData(MeshRenderer->ParticleMesh->GetPackage()->GetFName());
+	if (!Test.TestNotNull(TEXT("The widget baked the particle mesh"), MeshLODs))
+		return false;
+
+	TSharedRef<SNiagaraUISystemWidget> SlateWidget = StaticCastSharedRef<SNiagaraUISystemWidget>(Widget->TakeWidget());
+	return MeshLODs->ContainsByPredicate([&SlateWidget](const FSlateMeshDataPtr& MeshLOD) { return SlateWidget->HasResidentGeometry(MeshLOD.Get()); });
+}
+
+static UNiagaraSystem* LoadMeshSystem(FAutomationTestBase& Test, UNiagaraMeshRendererProperties*& OutMeshRenderer)
+{
+	UNiagaraSystem* System = LoadObject<UNiagaraSystem>(nullptr, MeshSystemPath);
+	if (!Test.TestNotNull(TEXT("The mesh renderer system is loaded"), System))
+		return nullptr;
+
+#if WITH_EDITOR
+	System->WaitForCompilationComplete();
+#endif
+
+	OutMeshRenderer = FindMeshRenderer(System);
+	if (!Test.TestNotNull(TEXT("The system has a mesh renderer"), OutMeshRenderer))
+		return nullptr;
+
+	return System;
+}
+
+// A shared simulation is owned by the world rather than by any widget, every widget painting it draws the particle
+// meshes it baked itself
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNiagaraUISharedSimulationMeshTest, "NiagaraUI.SharedSimulation.MeshRenderer", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ProductFilter)
+
+bool FNiagaraUISharedSimulationMeshTest::RunTest(const FString& Parameters)
+{
+	if (!FSlateApplication::IsInitialized())
+	{
+		AddError(TEXT("The test paints the widgets through Slate, which isn't initialized"));
+		return false;
+	}
+
+	UNiagaraMeshRendererProperties* MeshRenderer = nullptr;
+	UNiagaraSystem* System = LoadMeshSystem(*this, MeshRenderer);
+	if (!System)
+		return false;
+
+	FNiagaraUITestWorld TestWorld(TEXT("NiagaraUISharedSimulationMeshTest"), FVector2D(1024.f, 512.f));
+
+	UNiagaraSystemWidget* Widgets[2];
+	for (UNiagaraSystemWidget*& Widget : Widgets)
+	{
+		Widget = TestWorld.ConstructWidget(System);
+		Widget->ShareSimulation = true;
+		TestWorld.ShowWidget(Widget, UE_ARRAY_COUNT(Widgets));
+	}
+
+	for (int32 FrameIndex = 0; FrameIndex < 30; ++FrameIndex)
+	{
+		TestWorld.StepFrame(1.f / 60.f);
+	}
+
+	UNiagaraUIComponent* SharedComponent = Widgets[0]->GetNiagaraComponent();
+	if (!TestNotNull(TEXT("The widgets create a component"), SharedComponent))
+		return false;
+
+	TestTrue(TEXT("Both widgets paint the same simulation"), Widgets[1]->GetNiagaraComponent() == SharedComponent);
+	TestTrue(TEXT("The shared component isn't owned by a widget"), !SharedComponent->GetOuter()->IsA<UNiagaraSystemWidget>());
+	TestTrue(TEXT("The simulation has particles"), TestWorld.GetNumParticles() > 0);
+
+	for (UNiagaraSystemWidget* Widget : Widgets)
+	{
+		TestTrue(FString::Printf(TEXT("%s draws the particle mesh"), *Widget->GetName()), DrawsParticleMesh(*this, Widget, MeshRenderer));
+	}
+
+	return true;
+}
+
+// Prewarmed simulations are owned by the world and keep that outer once a widget claims them
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNiagaraUIPrewarmedMeshTest, "NiagaraUI.Prewarm.MeshRenderer", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ProductFilter)
+
+bool FNiagaraUIPrewarmedMeshTest::RunTest(const FString& Parameters)
+{
+	if (!FSlateApplication::IsInitialized())
+	{
+		AddError(TEXT("The test paints the widgets through Slate, which isn't initialized"));
+		return false;
+	}
+
+	UNiagaraMeshRendererProperties* MeshRenderer = nullptr;
+	UNiagaraSystem* System = LoadMeshSystem(*this, MeshRenderer);
+	if (!System)
+		return false;
+
+	FNiagaraUITestWorld TestWorld(TEXT("NiagaraUIPrewarmedMeshTest"), FVector2D(512.f, 512.f));
+
+	UNiagaraUIPrewarmSubsystem* PrewarmSubsystem = TestWorld.GetWorld()->GetSubsystem<UNiagaraUIPrewarmSubsystem>();
+	if (!TestNotNull(TEXT("The world has the prewarm subsystem"), PrewarmSubsystem))
+		return false;
+
+	PrewarmSubsystem->PrewarmSystem(System, 1, 0.5f);
+	for (int32 FrameIndex = 0; FrameIndex < 10; ++FrameIndex)
+	{
+		TestWorld.StepFrame(1.f / 60.f);
+	}
+
+	UNiagaraSystemWidget* Widget = TestWorld.ConstructWidget(System);
+	TestWorld.ShowWidget(Widget, 1);
+	for (int32 FrameIndex = 0; FrameIndex < 10; ++FrameIndex)
+	{
+		TestWorld.StepFrame(1.f / 60.f);
+	}
+
+	UNiagaraUIComponent* Component = Widget->GetNiagaraComponent();
+	if (!TestNotNull(TEXT("The widget has a component"), Component))
+		return false;
+
+	TestTrue(TEXT("The widget claimed the prewarmed component"), Component->GetOuter() == TestWorld.GetWorld());
+	TestTrue(TEXT("The simulation has particles"), TestWorld.GetNumParticles() > 0);
+	TestTrue(TEXT("The widget draws the particle mesh"), DrawsParticleMesh(*this, Widget, MeshRenderer));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
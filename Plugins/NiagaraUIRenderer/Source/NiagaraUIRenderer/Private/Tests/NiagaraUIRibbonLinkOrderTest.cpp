@@ -0,0 +1,67 @@
+// Copyright 2021 - Michal Smoleň
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "NiagaraUIParticleSort.h"
+#include "NiagaraUIParticleStreams.h"
+#include "NiagaraDataSet.h"
+#include "NiagaraRibbonRendererProperties.h"
+
+// Ribbons of emitters which don't write RibbonLinkOrder are linked by normalized age, which the data set stores without
+// the Particles namespace
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNiagaraUIRibbonLinkOrderFallbackTest, "NiagaraUI.Ribbon.LinkOrderFallback", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ProductFilter)
+
+bool FNiagaraUIRibbonLinkOrderFallbackTest::RunTest(const FString& Parameters)
+{
+	UNiagaraRibbonRendererProperties* RibbonRenderer = NewObject<UNiagaraRibbonRendererProperties>();
+
+	FNiagaraDataSetCompiledData CompiledData;
+	CompiledData.Variables.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetVec3Def(), TEXT("Position")));
+	CompiledData.Variables.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetFloatDef(), TEXT("NormalizedAge")));
+	CompiledData.SimTarget = ENiagaraSimTarget::CPUSim;
+	CompiledData.BuildLayout();
+
+	FNiagaraDataSet DataSet;
+	DataSet.Init(&CompiledData);
+	DataSet.BeginSimulate();
+
+	// Particles in buffer order aren't in age order
+	const float Ages[] = { 0.5f, 0.1f, 0.9f, 0.3f, 0.7f };
+	const int32 ParticleCount = UE_ARRAY_COUNT(Ages);
+	FNiagaraDataBuffer& DestinationData = DataSet.GetDestinationDataChecked();
+	DestinationData.Allocate(ParticleCount);
+	DestinationData.SetNumInstances(ParticleCount);
+	float* AgeComponent = reinterpret_cast<float*>(DestinationData.GetComponentPtrFloat(CompiledData.VariableLayouts[1].FloatComponentStart));
+	FMemory::Memcpy(AgeComponent, Ages, sizeof(Ages));
+	DataSet.EndSimulate();
+
+	const FNiagaraDataBuffer& ParticleData = *DataSet.GetCurrentData();
+	const FNiagaraUIFloatStream<1> LinkOrderData(DataSet, ParticleData, RibbonRenderer->RibbonLinkOrderBinding.GetDataSetBindableVariable().GetName());
+	const FNiagaraUIFloatStream<1> NormalizedAgeData(DataSet, ParticleData, NiagaraUIRibbonNormalizedAgeName(*RibbonRenderer));
+
+	TestFalse(TEXT("The emitter writes no link order"), LinkOrderData.IsValid());
+	if (!TestTrue(TEXT("The normalized age stream is found in the data set"), NormalizedAgeData.IsValid()))
+		return false;
+
+	TArray<uint32> Keys;
+	TArray<int32> Indices;
+	for (int32 Index = 0; Index < ParticleCount; ++Index)
+	{
+		Keys.Add(NiagaraUISortKey(NormalizedAgeData.Get(Index)));
+		Indices.Add(Index);
+	}
+	NiagaraUISortNearlySorted(Indices.GetData(), ParticleCount, Keys.GetData());
+
+	const int32 ExpectedOrder[] = { 1, 3, 0, 4, 2 };
+	for (int32 Index = 0; Index < ParticleCount; ++Index)
+	{
+		TestEqual(FString::Printf(TEXT("Link %d"), Index), Indices[Index], ExpectedOrder[Index]);
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
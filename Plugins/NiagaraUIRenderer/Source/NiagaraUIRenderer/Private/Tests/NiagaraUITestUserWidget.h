@@ -0,0 +1,14 @@
+// Copyright 2021 - Michal Smoleň
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Blueprint/UserWidget.h"
+#include "NiagaraUITestUserWidget.generated.h"
+
+// Owner of the widget tree tests construct their widgets in, UWidget::GetWorld only finds the world through one
+UCLASS(Transient, HideDropdown, NotBlueprintable)
+class UNiagaraUITestUserWidget : public UUserWidget
+{
+	GENERATED_BODY()
+};
@@ -0,0 +1,115 @@
+// Copyright 2021 - Michal Smoleň
+
+#include "NiagaraUITestWorld.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "NiagaraUITestUserWidget.h"
+#include "NiagaraSystemWidget.h"
+#include "NiagaraUIComponent.h"
+#include "NiagaraSystemInstance.h"
+#include "NiagaraEmitterInstance.h"
+#include "Blueprint/WidgetTree.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Widgets/SVirtualWindow.h"
+#include "Widgets/Layout/SUniformGridPanel.h"
+#include "Rendering/DrawElements.h"
+
+FNiagaraUITestWorld::FNiagaraUITestWorld(const TCHAR* WorldName, const FVector2D& WindowSize)
+{
+	World = UWorld::CreateWorld(EWorldType::Game, false, WorldName);
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	World->InitializeActorsForPlay(FURL());
+	World->BeginPlay();
+
+	UserWidget.Reset(NewObject<UNiagaraUITestUserWidget>(World));
+	UserWidget->WidgetTree = NewObject<UWidgetTree>(UserWidget.Get(), NAME_None, RF_Transient);
+
+	Grid = SNew(SUniformGridPanel);
+	Window = SNew(SVirtualWindow).Size(WindowSize);
+	Window->SetContent(Grid.ToSharedRef());
+}
+
+FNiagaraUITestWorld::~FNiagaraUITestWorld()
+{
+	Window->SetContent(SNullWidget::NullWidget);
+	Grid.Reset();
+	Window.Reset();
+
+	for (const TStrongObjectPtr<UNiagaraSystemWidget>& Widget : Widgets)
+	{
+		Widget->ReleaseSlateResources(true);
+	}
+	Widgets.Empty();
+	UserWidget.Reset();
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+}
+
+UNiagaraSystemWidget* FNiagaraUITestWorld::ConstructWidget(UNiagaraSystem* System)
+{
+	UNiagaraSystemWidget* Widget = UserWidget->WidgetTree->ConstructWidget<UNiagaraSystemWidget>();
+	Widget->NiagaraSystemReference = System;
+	Widget->DisableWarnings = true;
+	Widgets.Emplace(Widget);
+	return Widget;
+}
+
+void FNiagaraUITestWorld::ShowWidget(UNiagaraSystemWidget* Widget, int32 NumColumns)
+{
+	Grid->AddSlot(NumShownWidgets % NumColumns, NumShownWidgets / NumColumns)
+	[
+		Widget->TakeWidget()
+	];
+	++NumShownWidgets;
+}
+
+void FNiagaraUITestWorld::StepFrame(float DeltaSeconds, uint64& OutSimulateCycles, uint64& OutPaintCycles)
+{
+	CurrentTime += DeltaSeconds;
+
+	const uint64 SimulateStart = FPlatformTime::Cycles64();
+	World->Tick(LEVELTICK_All, DeltaSeconds);
+
+	const uint64 PaintStart = FPlatformTime::Cycles64();
+	Window->SlatePrepass(1.f);
+	FSlateWindowElementList ElementList(Window);
+	Window->PaintWindow(CurrentTime, DeltaSeconds, ElementList, FWidgetStyle(), true);
+	const uint64 PaintEnd = FPlatformTime::Cycles64();
+
+	OutSimulateCycles = PaintStart - SimulateStart;
+	OutPaintCycles = PaintEnd - PaintStart;
+}
+
+void FNiagaraUITestWorld::StepFrame(float DeltaSeconds)
+{
+	uint64 SimulateCycles, PaintCycles;
+	StepFrame(DeltaSeconds, SimulateCycles, PaintCycles);
+}
+
+int32 FNiagaraUITestWorld::GetNumParticles() const
+{
+	TSet<UNiagaraUIComponent*> Components;
+	for (const TStrongObjectPtr<UNiagaraSystemWidget>& Widget : Widgets)
+	{
+		Components.Add(Widget->GetNiagaraComponent());
+	}
+
+	int32 NumParticles = 0;
+	for (UNiagaraUIComponent* Component : Components)
+	{
+		if (!Component || !Component->GetSystemInstance())
+			continue;
+
+		for (const auto& EmitterInstance : Component->GetSystemInstance()->GetEmitters())
+		{
+			NumParticles += EmitterInstance->GetNumParticles();
+		}
+	}
+	return NumParticles;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
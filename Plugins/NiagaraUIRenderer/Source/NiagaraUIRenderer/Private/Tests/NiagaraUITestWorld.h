@@ -0,0 +1,58 @@
+// Copyright 2021 - Michal Smoleň
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "UObject/StrongObjectPtr.h"
+
+class UWorld;
+class UNiagaraSystem;
+class UNiagaraSystemWidget;
+class UNiagaraUITestUserWidget;
+class SUniformGridPanel;
+class SVirtualWindow;
+
+/**
+ * Game world with a virtual window for tests painting Niagara widgets headless. Widgets are constructed in the widget tree
+ * of a user widget owned by the world, the same way a widget blueprint creates them, so they find the world and create
+ * their components. The world is destroyed with the test world.
+ */
+class FNiagaraUITestWorld
+{
+public:
+	FNiagaraUITestWorld(const TCHAR* WorldName, const FVector2D& WindowSize);
+	~FNiagaraUITestWorld();
+
+	UNiagaraSystemWidget* ConstructWidget(UNiagaraSystem* System);
+
+	// Lays the widget out in a grid of NumColumns filling the window
+	void ShowWidget(UNiagaraSystemWidget* Widget, int32 NumColumns);
+
+	// Ticks the world and paints the window, returning the cycles spent in both
+	void StepFrame(float DeltaSeconds, uint64& OutSimulateCycles, uint64& OutPaintCycles);
+	void StepFrame(float DeltaSeconds);
+
+	// Particles of the components of all widgets, a shared component counts once
+	int32 GetNumParticles() const;
+
+	UWorld* GetWorld() const { return World; }
+
+private:
+	UWorld* World = nullptr;
+
+	TStrongObjectPtr<UNiagaraUITestUserWidget> UserWidget;
+
+	TArray<TStrongObjectPtr<UNiagaraSystemWidget>> Widgets;
+
+	TSharedPtr<SUniformGridPanel> Grid;
+	TSharedPtr<SVirtualWindow> Window;
+
+	int32 NumShownWidgets = 0;
+
+	double CurrentTime = 0.0;
+};
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -19,6 +19,15 @@ struct FSlateMeshData
 
 	UPROPERTY()
 		FName MeshPackageName;
+	// LOD of the static mesh the data was baked from, the LODs of a mesh are baked in order
+	UPROPERTY()
+		int32 LODIndex = 0;
+	// Screen size of the static mesh LOD, the LOD is used while the mesh covers less of the reference height
+	UPROPERTY()
+		float ScreenSize = 0.f;
+	// Distance of the farthest vertex from the mesh origin
+	UPROPERTY()
+		float Radius = 0.f;
     UPROPERTY()
         TArray<FVector2D> Vertex;
     UPROPERTY()
@@ -30,6 +39,9 @@ struct FSlateMeshData
 
 };
 
+// Baked mesh LOD shared by all widgets using the mesh
+typedef TSharedPtr<const FSlateMeshData, ESPMode::ThreadSafe> FSlateMeshDataPtr;
+
 
 /**
  The Niagara System Widget allows to render niagara particle system directly into the UI. Only sprite and ribbon CPU particles are supported.
@@ -48,17 +60,40 @@ public:
 	
 	virtual void ReleaseSlateResources(bool bReleaseChildren) override;
 
+	virtual void PostLoad() override;
+
 #if WITH_EDITOR
 	virtual const FText GetPaletteCategory() override;
 
 	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
 
 	void ValidateCompiledDefaults(class IWidgetCompilerLog& CompileLog) const override;
+
+	virtual void PreSave(const class ITargetPlatform* TargetPlatform) override;
 #endif
 
+	// Acquires the shared UI geometry of the system's particle meshes, from the data baked into the widget, from other
+	// widgets or by baking the mesh. Meshes need to allow CPU access to be baked in cooked builds
+	void AcquireMeshData() const;
+
+	// Returns the baked LODs of the particle mesh in LOD order, null when the mesh isn't baked
+	const TArray<FSlateMeshDataPtr>* FindMeshData(FName MeshPackageName) const;
+
 private:
 	void InitializeNiagaraUI();
 
+#if WITH_EDITOR
+	void BakeSerializedMeshData() const;
+#endif
+
+	// Moves the data baked into the widget to the shared mesh data cache
+	void ShareSerializedMeshData() const;
+
+	class UNiagaraUIComponent* CreateNiagaraComponent(UObject* Outer, class UWorld* World);
+
+	// Drops the subscription to the shared simulation, the next InitializeNiagaraUI subscribes again
+	void ReleaseSharedSimulation();
+
 public:
 	// Activate Niagara System with option to reset the simulation
 	UFUNCTION(BlueprintCallable, Category = "Niagara UI Renderer")
@@ -93,7 +128,7 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Niagara UI Renderer", BlueprintSetter = UpdateTickWhenPaused)
 	bool TickWhenPaused = false;
 
-	// Scale particles based on their position in Y-axis (towards the camera)
+	// Scale sprites based on their position in Y-axis (towards the camera). Sprites at or beyond Fake Depth Scale Distance aren't drawn
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara UI Renderer", AdvancedDisplay)
 	bool FakeDepthScale = false;
 
@@ -101,6 +136,22 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara UI Renderer", AdvancedDisplay, meta = (EditCondition = "FakeDepthScale"))
 	float FakeDepthScaleDistance = 1000.f;
 
+	// Generate the particle geometry in background tasks right after the simulation ticks instead of while painting. The widget then shows the last finished frame, one frame behind
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara UI Renderer", AdvancedDisplay)
+	bool AsyncGeneration = false;
+
+	// Simulate the system once for all widgets in the world which share the simulation of the same system with the same Auto Activate, Tick When Paused and Simulation Rate. Meant for looping local space effects shown many times, like button glows. Activating, deactivating or resetting the system affects every widget sharing it. Shared simulations generate their geometry while painting
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara UI Renderer", AdvancedDisplay)
+	bool ShareSimulation = false;
+
+	// Simulation steps per second, 0 simulates every frame. Lower rates like 30, 20 or 15 save simulation time on background effects, sprites and meshes are drawn interpolated between the last two steps. Ignored by prewarmed simulations
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara UI Renderer", AdvancedDisplay, meta = (ClampMin = "0"))
+	float SimulationRate = 0.f;
+
+	// Share of the UI particle budget this widget gets relative to other widgets of the same on-screen size. Only matters when NiagaraUI.Budget.MaxParticles or NiagaraUI.Budget.MaxGenerateTimeMs is set
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara UI Renderer", AdvancedDisplay, meta = (ClampMin = "0"))
+	float BudgetPriority = 1.f;
+
 	// Show debug particle system we're rendering in the game world. It'll be near 0 0 0
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara UI Renderer", AdvancedDisplay)
 	bool ShowDebugSystemInWorld = false;
@@ -109,12 +160,19 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara UI Renderer", AdvancedDisplay)
 	bool DisableWarnings = false;
 
+	// Geometry baked at compile and cook time. Once loaded it's moved to the shared mesh data cache outside of the editor
     UPROPERTY()
 	mutable TArray<FSlateMeshData> MeshData;
 
 private:
+	// Shared mesh LODs used by this widget by mesh package
+	mutable TMap<FName, TArray<FSlateMeshDataPtr>> MeshDataHandles;
+
 	TSharedPtr<SNiagaraUISystemWidget> NiagaraSlateWidget;
 
 	UPROPERTY()
 	class UNiagaraUIComponent* NiagaraComponent;
+
+	// NiagaraComponent is a shared simulation this widget subscribed to
+	bool UsesSharedSimulation = false;
 };
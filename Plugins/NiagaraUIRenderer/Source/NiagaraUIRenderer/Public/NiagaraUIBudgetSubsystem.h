@@ -0,0 +1,54 @@
+// Copyright 2021 - Michal Smoleň
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+
+#include "NiagaraUIBudgetSubsystem.generated.h"
+
+class UNiagaraUIComponent;
+
+/**
+ * Keeps the cost of all UI particles in a world under NiagaraUI.Budget.MaxParticles and NiagaraUI.Budget.MaxGenerateTimeMs.
+ * The world budget follows the measured generation time, it's split between the components by their priority and
+ * visible area and enforced by rendering fewer sprites and meshes and by scaling the User.NiagaraUISpawnScale parameter
+ * of the systems which expose it.
+ */
+UCLASS()
+class NIAGARAUIRENDERER_API UNiagaraUIBudgetSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	void RegisterComponent(UNiagaraUIComponent* Component);
+
+	void UnregisterComponent(UNiagaraUIComponent* Component);
+
+	// Particles all UI components of the world may render, 0 while no budget is set
+	int32 GetParticleBudget() const { return FMath::CeilToInt(ParticleBudget); }
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual ETickableTickType GetTickableTickType() const override;
+
+	virtual bool IsTickable() const override;
+
+	// UI keeps rendering in pause menus
+	virtual bool IsTickableWhenPaused() const override { return true; }
+
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+	virtual TStatId GetStatId() const override;
+
+private:
+	TArray<TWeakObjectPtr<UNiagaraUIComponent>> Components;
+
+	// World budget, adjusted every frame while a time budget is set
+	float ParticleBudget = 0.f;
+
+	float SmoothedGenerateTimeMs = 0.f;
+};
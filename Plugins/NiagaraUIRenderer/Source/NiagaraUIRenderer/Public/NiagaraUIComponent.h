@@ -10,7 +10,139 @@
 #include "NiagaraUIComponent.generated.h"
 
 class SNiagaraUISystemWidget;
+class UNiagaraRendererProperties;
+class UNiagaraUIComponent;
+class FNiagaraDataBuffer;
+struct FSlateMeshData;
 
+enum class ENiagaraUIRendererType : uint8
+{
+	Sprite,
+	Ribbon,
+	Mesh
+};
+
+// Layout of the sprite and mesh instance data, picked by the renderer's material through its NiagaraUIInstanceFormat
+// scalar parameter. See NiagaraUIInstancePacking.h
+enum class ENiagaraUIInstanceFormat : uint8
+{
+	Compact,
+	Wide
+};
+
+// Keys and particle indices of one renderer's sort. Kept between frames, so the sort doesn't allocate once the
+// emitter reached its particle count
+struct FNiagaraUIParticleSortBuffers
+{
+	// One key per particle, filled before NiagaraUIRadixSort
+	TArray<uint32> Keys;
+
+	// Particle indices in sorted order after NiagaraUIRadixSort
+	TArray<int32> Indices;
+
+	TArray<uint32> KeysScratch;
+	TArray<int32> IndicesScratch;
+
+	// Particle index in the previous data buffer by ID table index, for the interpolation of reduced simulation rates
+	TArray<int32> PreviousIndexByID;
+
+	// Ribbon grouping: group of every ribbon ID, the ribbon ID of every group and the first index of every group in Indices
+	TMap<FNiagaraID, int32> RibbonGroups;
+	TArray<FNiagaraID> RibbonGroupIDs;
+	TArray<int32> RibbonGroupOffsets;
+};
+
+// Renderer of the system instance which can be rendered into the UI, already resolved to its type
+struct FNiagaraUIRendererEntry
+{
+	FNiagaraUIRendererEntry(ENiagaraUIRendererType TypeIn, UNiagaraRendererProperties* PropertiesIn, TSharedRef<const FNiagaraEmitterInstance, ESPMode::ThreadSafe> EmitterInstIn, int32 EmitterIndexIn)
+		: Type(TypeIn), RendererProperties(PropertiesIn), EmitterInstance(EmitterInstIn), EmitterIndex(EmitterIndexIn) {}
+
+	ENiagaraUIRendererType Type;
+	UNiagaraRendererProperties* RendererProperties;
+	TSharedRef<const FNiagaraEmitterInstance, ESPMode::ThreadSafe> EmitterInstance;
+	int32 EmitterIndex;
+
+	ENiagaraUIInstanceFormat InstanceFormat = ENiagaraUIInstanceFormat::Compact;
+
+	// Only touched by the job generating this renderer
+	mutable FNiagaraUIParticleSortBuffers SortBuffers;
+};
+
+// Render data slots of one renderer for the current frame. Slots are reserved on the game thread, then the geometry
+// can be generated on any thread and the filled slots are submitted back on the game thread in renderer order
+struct FNiagaraUIRendererJob
+{
+	const FNiagaraUIRendererEntry* Renderer = nullptr;
+
+	// Reserved slots, filled from the front
+	TArray<int32, TInlineAllocator<1>> RenderDataIndices;
+
+	// Number of reserved slots filled this frame
+	int32 NumFilledRenderData = 0;
+
+	// Baked LOD of the mesh picked for the widget's scale
+	const FSlateMeshData* MeshData = nullptr;
+
+	// Particle data captured when the job was reserved. Asynchronous jobs hold a read reference on it, so the
+	// simulation can't overwrite it while the geometry is generated
+	FNiagaraDataBuffer* DataBuffer = nullptr;
+	bool HoldsReadRef = false;
+
+	// Data of the simulation step before DataBuffer and how far the paint is between the two, set with a reduced
+	// simulation rate. The read reference is held together with the one of DataBuffer
+	FNiagaraDataBuffer* PreviousDataBuffer = nullptr;
+	float InterpolationAlpha = 1.f;
+
+	// Absolute space rect of the widget's paint, geometry outside of it isn't generated
+	FSlateRect CullingRect;
+
+	// Sprites and meshes past this many particles aren't rendered, set from the budget of the component
+	int32 MaxParticles = MAX_int32;
+};
+
+// Particle data of one emitter before the last simulation step
+struct FNiagaraUIPreviousParticleData
+{
+	TSharedPtr<const FNiagaraEmitterInstance, ESPMode::ThreadSafe> EmitterInstance;
+	FNiagaraDataBuffer* DataBuffer = nullptr;
+};
+
+// What a component used since the budget was last updated
+struct FNiagaraUIBudgetUsage
+{
+	float Priority = 1.f;
+
+	// Absolute space area of the emitter bounds inside the culling rects
+	float VisibleArea = 0.f;
+
+	// Particles of all renderer jobs reserved
+	int32 Particles = 0;
+
+	uint32 GenerateCycles = 0;
+};
+
+// Kicks the asynchronous geometry generation once the owning component has ticked
+USTRUCT()
+struct FNiagaraUIGenerateTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+
+	virtual FString DiagnosticMessage() override;
+
+	UNiagaraUIComponent* Owner = nullptr;
+};
+
+template<>
+struct TStructOpsTypeTraits<FNiagaraUIGenerateTickFunction> : public TStructOpsTypeTraitsBase2<FNiagaraUIGenerateTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
 
 /**
  * 
@@ -21,21 +153,146 @@ class NIAGARAUIRENDERER_API UNiagaraUIComponent : public UNiagaraComponent
 	GENERATED_BODY()
 
 public:
+	virtual void Activate(bool bReset = false) override;
+
+	virtual void OnRegister() override;
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	virtual void OnUnregister() override;
+
     void SetTransformationForUIRendering(const FTransform& Transform);
 
-	void RenderUI(SNiagaraUISystemWidget* NiagaraWidget, const FSlateLayoutTransform& SlateLayoutTransform, const FTransform& ComponentTransform, const FNiagaraWidgetProperties* WidgetProperties);
+	// Forces the cached renderer list to be rebuilt before the next render
+	void InvalidateRendererCache();
+
+	// Generates and submits the geometry of the widget. With asynchronous generation it only submits the last finished frame
+	// and remembers the transformation for the next generation. Particles outside of CullingRect are skipped
+	void RenderUI(SNiagaraUISystemWidget* NiagaraWidget, const FSlateLayoutTransform& SlateLayoutTransform, const FTransform& ComponentTransform, const FNiagaraWidgetProperties* WidgetProperties, const FSlateRect& CullingRect);
+
+	// Starts the asynchronous generation for the widget painted last, called by the generate tick function
+	void StartAsyncGeneration();
+
+	// Finishes any generation in flight and forgets the widget, called when the widget gets destroyed
+	void ReleaseAsyncWidget(SNiagaraUISystemWidget* NiagaraWidget);
+
+	// Returns the usage since the last call and starts counting again, called by UNiagaraUIBudgetSubsystem
+	FNiagaraUIBudgetUsage ConsumeBudgetUsage();
+
+	// Simulates the system RateHz times per second and draws sprites and meshes interpolated between the steps. 0 simulates every frame.
+	// Reduced rates force the instance to tick solo, so changing it may restart an active system
+	void SetSimulationRate(float RateHz);
+
+	// Limits the rendered particles and scales the User.NiagaraUISpawnScale parameter towards the budget. MAX_int32 removes the limit
+	void SetParticleBudget(int32 ParticleBudget);
+
+	// Whether the simulation is paused after NiagaraUI.SuspendAfterFrames frames without a paint. Enabling it starts the
+	// grace period again, pooled simulations which no widget paints yet keep it disabled
+	void SetSuspendWhileHidden(bool Enabled);
 
-	void AddSpriteRendererData(SNiagaraUISystemWidget* NiagaraWidget, TSharedRef<const FNiagaraEmitterInstance, ESPMode::ThreadSafe> EmitterInst,
+	void AddSpriteRendererData(SNiagaraUISystemWidget* NiagaraWidget, FNiagaraUIRendererJob& Job, const TSharedRef<const FNiagaraEmitterInstance, ESPMode::ThreadSafe>& EmitterInst,
 								class UNiagaraSpriteRendererProperties* SpriteRenderer, const FSlateLayoutTransform& SlateLayoutTransform, const FTransform& ComponentTransform, const FNiagaraWidgetProperties* WidgetProperties);
 
-	void AddRibbonRendererData(SNiagaraUISystemWidget* NiagaraWidget, TSharedRef<const FNiagaraEmitterInstance, ESPMode::ThreadSafe> EmitterInst,
+	void AddRibbonRendererData(SNiagaraUISystemWidget* NiagaraWidget, FNiagaraUIRendererJob& Job, const TSharedRef<const FNiagaraEmitterInstance, ESPMode::ThreadSafe>& EmitterInst,
                                 class UNiagaraRibbonRendererProperties* RibbonRenderer, const FSlateLayoutTransform& SlateLayoutTransform, const FTransform& ComponentTransform, const FNiagaraWidgetProperties* WidgetProperties);
 
-    void AddMeshRendererData(SNiagaraUISystemWidget* NiagaraWidget, TSharedRef<const FNiagaraEmitterInstance, ESPMode::ThreadSafe> EmitterInst,
+    void AddMeshRendererData(SNiagaraUISystemWidget* NiagaraWidget, FNiagaraUIRendererJob& Job, const TSharedRef<const FNiagaraEmitterInstance, ESPMode::ThreadSafe>& EmitterInst,
         class UNiagaraMeshRendererProperties* MeshRenderer, const FSlateLayoutTransform& SlateLayoutTransform, const FTransform& ComponentTransform, const FNiagaraWidgetProperties* WidgetProperties);
 
+private:
+	void PresizeRenderData(SNiagaraUISystemWidget* NiagaraWidget);
+
+	bool ReserveRendererJobs(SNiagaraUISystemWidget* NiagaraWidget, bool HoldReadRefs, const FSlateLayoutTransform& SlateLayoutTransform, const FTransform& ComponentTransform, const FSlateRect& CullingRect);
+
+	void ReserveRendererJob(SNiagaraUISystemWidget* NiagaraWidget, const FNiagaraUIRendererEntry& Renderer, FNiagaraUIRendererJob& Job, bool HoldReadRef, float LayoutScale);
+
+	void SubmitRendererJobs(SNiagaraUISystemWidget* NiagaraWidget);
+
+	void ReleaseRendererJobs();
+
+	void WaitForAsyncGeneration();
+
+	// Unpauses a simulation paused while its widget wasn't painted, fast-forwarding it by up to NiagaraUI.ResumeCatchUpSeconds
+	void ResumeIfSuspended();
+
+	// World time the suspension and the simulation steps are measured in, follows the pause setting of the component tick
+	double GetClockSeconds() const;
+
+	// Holds the current particle data of all emitters before a simulation step
+	void CapturePreviousParticleData();
+
+	void ReleasePreviousParticleData();
+
+	void GenerateRendererData(SNiagaraUISystemWidget* NiagaraWidget, FNiagaraUIRendererJob& Job, const FSlateLayoutTransform& SlateLayoutTransform, const FTransform& ComponentTransform, const FNiagaraWidgetProperties* WidgetProperties);
+
+	bool IsRendererCacheValid() const;
+
+	void BuildRendererCache();
+
+#if WITH_EDITOR
+	void OnSystemCompiled(UNiagaraSystem* System);
+#endif
 	
 private:
+	// Supported renderers of the current system instance sorted by their SortOrderHint
+	TArray<FNiagaraUIRendererEntry> CachedRenderers;
+
+	const FNiagaraSystemInstance* CachedRenderersSystemInstance = nullptr;
+
+	bool RendererCacheDirty = true;
+
+	// Per frame jobs of the enabled renderers, kept to reuse the allocations
+	TArray<FNiagaraUIRendererJob> RendererJobs;
+
+	FNiagaraUIGenerateTickFunction GenerateTickFunction;
+
+	// Widget and transformation of the last paint, used by the asynchronous generation
+	SNiagaraUISystemWidget* AsyncWidget = nullptr;
+	FSlateLayoutTransform AsyncLayoutTransform;
+	FTransform AsyncComponentTransform;
+	FNiagaraWidgetProperties AsyncWidgetProperties = FNiagaraWidgetProperties(true, false, false, 1.f);
+	FSlateRect AsyncCullingRect;
+
+	FGraphEventArray AsyncGenerateTasks;
+
+	// Jobs were generated asynchronously and wait to be submitted by the next paint
+	bool AsyncGenerationPending = false;
+
+#if WITH_EDITOR
+	TWeakObjectPtr<UNiagaraSystem> CompileDelegateSystem;
+#endif
+
+	FNiagaraUIBudgetUsage BudgetUsage;
+
+	// Generation tasks add their time here, it's moved to BudgetUsage when the usage is consumed
+	FThreadSafeCounter BudgetGenerateCycles;
+
+	// Particle demand the current budget was set for
+	int32 BudgetParticleDemand = 0;
+
+	// Fraction of the particles of every sprite and mesh job which is rendered
+	float BudgetRenderFraction = 1.f;
+
+	float BudgetSpawnScale = 1.f;
+
+	// Seconds between simulation steps, 0 simulates every frame
+	float SimulationInterval = 0.f;
+
+	double LastSimulationTime = 0.0;
+
+	// Particle data before the last simulation step by emitter index, only kept with a reduced simulation rate
+	TArray<FNiagaraUIPreviousParticleData> PreviousParticleData;
+
+	// Frame of the last paint of any widget using the component, or of the activation when it wasn't painted since
+	uint64 LastPaintFrame = 0;
+
+	bool SuspendWhileHidden = true;
+
+	// The simulation was paused because no widget painted it
+	bool SuspendedWhileHidden = false;
+	double SuspendedTime = 0.0;
+
 	bool ShouldActivateParticle = false;
+	bool PresizeRenderDataPending = true;
 	float WidgetAngleRad = 0.f;
 };
@@ -0,0 +1,75 @@
+// Copyright 2021 - Michal Smoleň
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+
+#include "NiagaraUIPrewarmSubsystem.generated.h"
+
+class UNiagaraSystem;
+class UNiagaraUIComponent;
+
+// Warmed simulations of one system waiting for widgets
+USTRUCT()
+struct FNiagaraUIPrewarmPool
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	UNiagaraSystem* System = nullptr;
+
+	UPROPERTY()
+	TArray<UNiagaraUIComponent*> Components;
+
+	// Simulated seconds of every component in Components
+	TArray<float> WarmedSeconds;
+
+	bool TickWhenPaused = false;
+	int32 Size = 0;
+	float WarmupSeconds = 0.f;
+};
+
+/**
+ * Keeps simulations of UI particle systems warmed up before their widgets are created, so looping effects show up in
+ * their steady state the frame a menu opens. The warmup is spread over several frames, warmed simulations are paused
+ * until a widget of the same system claims them and the pool refills itself afterwards.
+ */
+UCLASS()
+class NIAGARAUIRENDERER_API UNiagaraUIPrewarmSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// Keeps Count simulations of the system warmed up by WarmupSeconds for auto activated widgets with the same Tick When Paused. Count 0 empties the pool
+	UFUNCTION(BlueprintCallable, Category = "Niagara UI Renderer")
+	void PrewarmSystem(UNiagaraSystem* System, int32 Count = 1, float WarmupSeconds = 2.f, bool TickWhenPaused = false);
+
+	// Takes the warmest simulation of the system out of the pool and resumes it, null when there is none
+	UNiagaraUIComponent* ClaimPrewarmed(UNiagaraSystem* System, bool TickWhenPaused);
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual ETickableTickType GetTickableTickType() const override;
+
+	virtual bool IsTickable() const override;
+
+	virtual bool IsTickableWhenPaused() const override { return true; }
+
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+	virtual TStatId GetStatId() const override;
+
+private:
+	FNiagaraUIPrewarmPool* FindPool(UNiagaraSystem* System, bool TickWhenPaused);
+
+	UNiagaraUIComponent* CreatePrewarmComponent(const FNiagaraUIPrewarmPool& Pool);
+
+	static void DestroyPrewarmComponent(UNiagaraUIComponent* Component);
+
+	UPROPERTY()
+	TArray<FNiagaraUIPrewarmPool> Pools;
+};
@@ -7,11 +7,13 @@ class UMaterialInterface;
 struct FNiagaraWidgetProperties
 {
 	FNiagaraWidgetProperties();
-	FNiagaraWidgetProperties(bool inAutoActivate, bool inShowDebugSystem, bool inFakeDepthScale, float inFakeDepthDistance)
-        : AutoActivate(inAutoActivate), ShowDebugSystemInWorld(inShowDebugSystem), FakeDepthScale(inFakeDepthScale), FakeDepthScaleDistance(inFakeDepthDistance) {}
+	FNiagaraWidgetProperties(bool inAutoActivate, bool inShowDebugSystem, bool inFakeDepthScale, float inFakeDepthDistance, bool inAsyncGeneration = false, float inBudgetPriority = 1.f)
+        : AutoActivate(inAutoActivate), ShowDebugSystemInWorld(inShowDebugSystem), FakeDepthScale(inFakeDepthScale), FakeDepthScaleDistance(inFakeDepthDistance), AsyncGeneration(inAsyncGeneration), BudgetPriority(inBudgetPriority) {}
 	
 	bool AutoActivate = true;
 	bool ShowDebugSystemInWorld = false;
 	bool FakeDepthScale = false;
 	float FakeDepthScaleDistance = 1000.f;
+	bool AsyncGeneration = false;
+	float BudgetPriority = 1.f;
 };
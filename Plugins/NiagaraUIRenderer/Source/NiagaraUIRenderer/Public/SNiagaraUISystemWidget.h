@@ -7,8 +7,34 @@
 #include "Slate/SMeshWidget.h"
 
 class UNiagaraUIComponent;
+class UNiagaraSystemWidget;
 class UMaterialInterface;
+class UNiagaraRendererProperties;
 
+/**
+ * Identifies one pooled render data slot of the widget. Slots are owned by a renderer of an emitter instance,
+ * SubIndex allows a single renderer to own more than one slot.
+ */
+struct FNiagaraUIRenderDataKey
+{
+	FNiagaraUIRenderDataKey() {}
+	FNiagaraUIRenderDataKey(const void* InEmitter, const UNiagaraRendererProperties* InRenderer, int32 InSubIndex = 0)
+		: Emitter(InEmitter), Renderer(InRenderer), SubIndex(InSubIndex) {}
+
+	bool operator==(const FNiagaraUIRenderDataKey& Other) const
+	{
+		return Emitter == Other.Emitter && Renderer == Other.Renderer && SubIndex == Other.SubIndex;
+	}
+
+	friend uint32 GetTypeHash(const FNiagaraUIRenderDataKey& Key)
+	{
+		return HashCombine(HashCombine(PointerHash(Key.Emitter), PointerHash(Key.Renderer)), ::GetTypeHash(Key.SubIndex));
+	}
+
+	const void* Emitter = nullptr;
+	const UNiagaraRendererProperties* Renderer = nullptr;
+	int32 SubIndex = 0;
+};
 
 
 /**
@@ -20,6 +46,8 @@ public:
 	SLATE_BEGIN_ARGS(SNiagaraUISystemWidget)
 	{		
 	}
+		// Widget holding the baked geometry of the particle meshes
+		SLATE_ARGUMENT(TWeakObjectPtr<const UNiagaraSystemWidget>, OwnerWidget)
 	SLATE_END_ARGS()
 
 	void Construct(const FArguments& Args);
@@ -28,22 +56,102 @@ public:
 
 	virtual int32 OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const override;
 
-	void AddRenderData(FSlateVertex** OutVertexData, SlateIndex** OutIndexData, UMaterialInterface* Material, int32 NumVertexData, int32 NumIndexData);
-	
-    int32 AddRenderDataWithInstance(FSlateVertex** OutVertexData, SlateIndex** OutIndexData, UMaterialInterface* Material, int32 NumVertexData, int32 NumIndexData);
+	// Starts generating a new frame of render data. Releases slots which weren't used for a while, the render runs
+	// of the previous frame stay valid until BeginRenderDataSubmit
+	void BeginRenderDataUpdate();
+
+	// Clears the render runs before the generated slots are submitted
+	void BeginRenderDataSubmit();
+
+	// Finishes the frame of render data, shrinks slots which stayed well below their capacity
+	void EndRenderDataUpdate();
+
+	// Finds or creates the render data slot of the key and assigns its material. Game thread only. Until the next
+	// BeginRenderDataUpdate the slot may be filled from any thread, as long as each slot is filled by one thread
+	int32 ReserveRenderData(const FNiagaraUIRenderDataKey& Key, UMaterialInterface* Material, bool WithInstances);
+
+	// Resizes the back vertex and index buffers of a reserved slot and marks it as used this frame
+	bool GetRenderDataBuffers(int32 RenderDataIndex, FSlateVertex** OutVertexData, SlateIndex** OutIndexData, int32 NumVertexData, int32 NumIndexData);
+
+	// Marks a reserved slot as used this frame for geometry which doesn't change between frames, like particle meshes.
+	// Returns true with the back buffers when the geometry of GeometrySource still has to be written, false when the
+	// slot already holds it and only its instances need to be generated
+	bool GetResidentRenderDataBuffers(int32 RenderDataIndex, const void* GeometrySource, FSlateVertex** OutVertexData, SlateIndex** OutIndexData, int32 NumVertexData, int32 NumIndexData);
+
+	// Shrinks the back buffers of a filled slot to the vertices and indices actually written, keeps their capacity
+	void TrimRenderData(int32 RenderDataIndex, int32 NumVertexData, int32 NumIndexData);
+
+	// Returns an empty instance array for the render data, reserved to the high water mark of the instances it submitted
+	FSlateInstanceBufferData& GetInstanceData(int32 RenderDataIndex);
+
+	// Swaps the back buffers of the filled slot in, adds a render run for it and uploads its instances. Slots without
+	// instances are drawn once. Game thread only, the runs are drawn in the order they were submitted
+	void SubmitRenderData(int32 RenderDataIndex);
+
+	// Reserves memory of the render data slot up front, so the first frames don't have to grow the buffers
+	void PresizeRenderData(const FNiagaraUIRenderDataKey& Key, int32 NumVertexData, int32 NumIndexData, int32 NumInstanceData);
 
 	void ClearRenderData();
 
+	// Brushes are shared by all widgets through FNiagaraUIMaterialBrushCache
 	TSharedPtr<FSlateMaterialBrush> CreateSlateMaterialBrush(UMaterialInterface* Material);
 
+	// Evicts brushes of the shared cache which no widget uses anymore, the cache also trims itself periodically
 	void CheckForInvalidBrushes();
 
 	void SetNiagaraComponentReference(TWeakObjectPtr<UNiagaraUIComponent> NiagaraComponentIn, FNiagaraWidgetProperties Properties);
 
+	// Particle meshes are found in the widget painting them, shared and prewarmed components aren't owned by any widget
+	const UNiagaraSystemWidget* GetOwnerWidget() const { return OwnerWidget.Get(); }
+
+	// Whether the render data drawn by the last paint holds the resident geometry of GeometrySource
+	bool HasResidentGeometry(const void* GeometrySource) const;
+
+private:
+	struct FRenderDataSlot
+	{
+		FNiagaraUIRenderDataKey Key;
+		// Back buffers written by the generation, the previous frame stays in RenderData until the slot is submitted
+		TArray<FSlateVertex> PendingVertexData;
+		TArray<SlateIndex> PendingIndexData;
+		// Instances are handed to the render thread on submit, only their high water mark carries over to the next frame
+		FSlateInstanceBufferData InstanceData;
+		int32 NumSubmittedInstances = 0;
+		int32 HighWaterVertices = 0;
+		int32 HighWaterIndices = 0;
+		int32 HighWaterInstances = 0;
+		uint32 LastUsedUpdate = 0;
+		// Update in which the back buffers were written, only written back buffers are swapped in
+		uint32 PendingWrittenUpdate = 0;
+		// Source of the resident geometry in RenderData and in the back buffers
+		const void* ResidentGeometry = nullptr;
+		const void* PendingResidentGeometry = nullptr;
+		// Material the brush of RenderData was created for
+		TWeakObjectPtr<UMaterialInterface> BrushMaterial;
+		bool WithInstances = false;
+		bool InUse = false;
+	};
+
+	int32 FindOrAddRenderDataSlot(const FNiagaraUIRenderDataKey& Key);
+
+	void ReleaseRenderDataSlot(int32 RenderDataIndex);
+
 private:
 	TWeakObjectPtr<UNiagaraUIComponent> NiagaraComponent;
 
-	static TMap<UMaterialInterface*, TSharedPtr<FSlateMaterialBrush>> MaterialBrushMap;
+	TWeakObjectPtr<const UNiagaraSystemWidget> OwnerWidget;
+
+	// Pooled slots, RenderDataSlots[i] describes RenderData[i]
+	TArray<FRenderDataSlot> RenderDataSlots;
+
+	TMap<FNiagaraUIRenderDataKey, int32> RenderDataSlotMap;
+
+	// Released slots are reused instead of removed, so slot indices stay valid while render data is generated
+	TArray<int32> FreeRenderDataSlots;
+
+	uint32 RenderDataUpdateCounter = 0;
+
+	int32 NumRenderRuns = 0;
 
 	FNiagaraWidgetProperties WidgetProperties = FNiagaraWidgetProperties(true, false, false, 1.f);
 };
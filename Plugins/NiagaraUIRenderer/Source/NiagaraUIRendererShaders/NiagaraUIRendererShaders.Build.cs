@@ -0,0 +1,27 @@
+// Copyright 2021 - Michal Smoleň
+
+using UnrealBuildTool;
+
+public class NiagaraUIRendererShaders : ModuleRules
+{
+	public NiagaraUIRendererShaders(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PublicDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"Core",
+			}
+			);
+			
+		
+		PrivateDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"RenderCore",
+				"Projects",
+			}
+			);
+	}
+}
@@ -0,0 +1,17 @@
+// Copyright 2021 - Michal Smoleň
+
+#include "NiagaraUIRendererShaders.h"
+#include "Interfaces/IPluginManager.h"
+#include "ShaderCore.h"
+
+void FNiagaraUIRendererShadersModule::StartupModule()
+{
+	// Lets material Custom nodes include the instance decode functions
+	const TSharedPtr<IPlugin> Plugin = IPluginManager::Get().FindPlugin(TEXT("NiagaraUIRenderer"));
+	if (Plugin.IsValid())
+	{
+		AddShaderSourceDirectoryMapping(TEXT("/Plugin/NiagaraUIRenderer"), FPaths::Combine(Plugin->GetBaseDir(), TEXT("Shaders")));
+	}
+}
+
+IMPLEMENT_MODULE(FNiagaraUIRendererShadersModule, NiagaraUIRendererShaders)
@@ -0,0 +1,18 @@
+// Copyright 2021 - Michal Smoleň
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Modules/ModuleManager.h"
+
+/**
+ * Maps the plugin's Shaders directory to /Plugin/NiagaraUIRenderer. Loads in PostConfigInit, before any shader is
+ * compiled, which is too early for the runtime module and its Niagara and UMG dependencies.
+ */
+class FNiagaraUIRendererShadersModule : public IModuleInterface
+{
+public:
+
+	/** IModuleInterface implementation */
+	virtual void StartupModule() override;
+};